@@ -4,8 +4,16 @@ include $(CLEAR_VARS)
 
 LOCAL_MODULE    := sfserialization
 LOCAL_SRC_FILES := \
+sfserialization/BinaryDeserialization.cpp \
+sfserialization/BinarySerialization.cpp \
 sfserialization/Deserialization.cpp \
+sfserialization/DeserializationContext.cpp \
+sfserialization/FieldMask.cpp \
+sfserialization/MappedFile.cpp \
+sfserialization/NDJSON.cpp \
+sfserialization/StringPool.cpp \
 sfserialization/Serialization.cpp \
-sfserialization/JSONParser.cpp
+sfserialization/JSONParser.cpp \
+sfserialization/ThreadPool.cpp
 
 include $(BUILD_SHARED_LIBRARY)
@@ -1,6 +1,7 @@
 #include "StructureParser.h"
 #include <stdio.h>
 #include <ctype.h>
+#include <stdlib.h>
 #include <assert.h>
 
 /// Prints out a string vec and marks the position p (for debugging purposes)
@@ -226,7 +227,30 @@ const RootElement * StructureParser::root () const {
 			}
 		}
 	}
-	// Case 6b: handling of SF_AUTOREFLECT_COMMAND(element-name)
+	// Case 6b: handling of SF_AUTOREFLECT_FIELDID(member-name, id)
+	if (finishing == ';'){
+		size_t size = mIncomingLine.size();
+		if (size == 6 && mIncomingLine[1] == "(" && mIncomingLine[3] == "," && mIncomingLine[5] == ")"){
+			const std::string & x (mIncomingLine.front());
+			size_t prefix = beginsWidth (x, mCommandPrefix);
+			if (prefix != x.npos && x.substr (prefix, x.npos) == "FIELDID"){
+				StackElement * element = mStack.top ();
+				if (element->type != StackElement::Class){
+					fprintf (stderr, "FIELDID command is only allowed inside classes\n");
+					return false;
+				}
+				int id = atoi (mIncomingLine[4].c_str());
+				if (id <= 0){
+					fprintf (stderr, "Invalid field id %s for member %s\n", mIncomingLine[4].c_str(), mIncomingLine[2].c_str());
+					return false;
+				}
+				static_cast<ClassElement*> (element)->fieldIds[mIncomingLine[2]] = id;
+				mIncomingLine.clear ();
+				return true;
+			}
+		}
+	}
+	// Case 6c: handling of SF_AUTOREFLECT_COMMAND(element-name)
 	if (finishing == ';'){
 		size_t size = mIncomingLine.size();
 		if (size >= 4){
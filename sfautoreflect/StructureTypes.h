@@ -146,14 +146,17 @@ struct ClassElement : public StackElement {
 	typedef std::pair<Visibility, VariableDefinition> MemberVariable;
 	typedef std::vector<Parent> ParentVec;
 	typedef std::vector<MemberVariable> MemberVariableVec;
+	typedef std::map<std::string, int> FieldIdMap;
 	ParentVec parents;
 	MemberVariableVec memberVariables;
+	FieldIdMap fieldIds;			///< Explicit field ids set by SF_AUTOREFLECT_FIELDID(member, id)
 
 	virtual void serialize (sf::Serialization & s) const {
 		StackElement::serialize (s);
 		if (isStruct) s ("isStruct", isStruct);
 		s ("parents", parents);
 		s ("memberVariables", memberVariables);
+		if (!fieldIds.empty()) s ("fieldIds", fieldIds);
 	}
 
 };
@@ -63,7 +63,7 @@ bool EnumGenerator::generateToString (const EnumElement * element) {
 		fprintf (mOutput, "\treturn \"UNDEFINED\";\n");
 	} else {
 		// with string table
-		fprintf (mOutput, "\tconst char* values[] = {\n");
+		fprintf (mOutput, "\tstatic const char* const values[] = {\n");
 		bool first = true;
 		for (EnumElement::ValueVec::const_iterator i = element->values.begin(); i != element->values.end(); i++){
 			fprintf (mOutput, "\t\t%s \"%s\"\n", first ? "" : ",", i->first.c_str());
@@ -86,6 +86,10 @@ bool EnumGenerator::generateFromString (const EnumElement * element) {
 	std::string enumName = classScope () + element->name;
 
 	fprintf (mOutput, "bool fromString (const char* key, %s &e){\n", enumName.c_str());
+	fprintf (mOutput, "\treturn fromString (key, strlen (key), e);\n");
+	fprintf (mOutput, "}\n\n");
+
+	fprintf (mOutput, "bool fromString (const char* key, size_t length, %s &e){\n", enumName.c_str());
 	if (!element->values.empty()){
 
 		// Generating Hash Table
@@ -93,7 +97,7 @@ bool EnumGenerator::generateFromString (const EnumElement * element) {
 		for (EnumElement::ValueVec::const_iterator i = element->values.begin(); i != element->values.end(); i++){
 			generator.add(i->first, classScope() + i->first);
 		}
-		bool suc = generator.generateHashCode(mOutput, enumName.c_str());
+		bool suc = generator.generatePerfectHashCode(mOutput, enumName.c_str(), "length");
 		if (!suc){
 			fprintf (stderr, "StaticHashTableBuilder failed\n");
 			return false;
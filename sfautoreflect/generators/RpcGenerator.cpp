@@ -4,22 +4,137 @@
 
 bool RpcGenerator::generate (const RootElement * tree) {
 	StackElement::CommandSet commands = tree->subCommands ();
-	if (!(commands.count ("RPC"))){
+	bool reuse = commands.count ("RPC_REUSE") > 0;
+	if (!(commands.count ("RPC") || reuse)){
 		return true; // nothing to do
 	}
 
 	fprintf (mOutput,
 			"#include <sfserialization/Serialization.h>\n"
 			"#include <sfserialization/Deserialization.h>\n");
+	if (reuse) fprintf (mOutput, "#include <boost/thread/tss.hpp>\n");
+	fprintf (mOutput, "\n");
+
+	// Helpers live in their own namespace, so that they cannot clash with names of the user
+	fprintf (mOutput, "namespace sf {\nnamespace detail {\n\n");
+
+	// Result handling of the different handler return types: void (synchronous), bool (synchronous result)
+	// and everything else (asynchronous result, handed off to sf::RpcAsyncTraits)
+	fprintf (mOutput, "template <class R> struct RpcResult {\n"
+						"\ttemplate <class C, class P, class A>\n"
+						"\tstatic bool call (R (C::*handler) (const sf::HostId &, const P &, const A &), C * instance, const sf::HostId & sender, const P & p, const A & a) {\n"
+						"\t\tsf::RpcAsyncTraits<R>::handOff ((instance->*handler) (sender, p, a));\n"
+						"\t\treturn true;\n"
+						"\t}\n"
+						"};\n\n"
+						"template <> struct RpcResult<void> {\n"
+						"\ttemplate <class C, class P, class A>\n"
+						"\tstatic bool call (void (C::*handler) (const sf::HostId &, const P &, const A &), C * instance, const sf::HostId & sender, const P & p, const A & a) {\n"
+						"\t\t(instance->*handler) (sender, p, a);\n"
+						"\t\treturn true;\n"
+						"\t}\n"
+						"};\n\n"
+						"template <> struct RpcResult<bool> {\n"
+						"\ttemplate <class C, class P, class A>\n"
+						"\tstatic bool call (bool (C::*handler) (const sf::HostId &, const P &, const A &), C * instance, const sf::HostId & sender, const P & p, const A & a) {\n"
+						"\t\treturn (instance->*handler) (sender, p, a);\n"
+						"\t}\n"
+						"};\n\n");
+
+	// Invokers, passing the payload to handlers taking a ByteArray (copies only if the payload is just a view)
+	// or a ByteView (never copies)
+	fprintf (mOutput, "template <class C, class P, class R, R (C::*handler) (const sf::HostId &, const P &, const sf::ByteArray & )>\n"
+						"struct RpcArrayInvoker {\n"
+						"\tstatic bool invoke (C * instance, const typename C::RpcCall & call, const P & p) {\n"
+						"\t\tif (call.array) {\n"
+						"\t\t\treturn RpcResult<R>::call (handler, instance, *call.sender, p, *call.array);\n"
+						"\t\t}\n"
+						"\t\tsf::ByteArray copy;\n"
+						"\t\tcopy.assign (call.data.begin(), call.data.end());\n"
+						"\t\treturn RpcResult<R>::call (handler, instance, *call.sender, p, copy);\n"
+						"\t}\n"
+						"};\n\n");
+	fprintf (mOutput, "template <class C, class P, class R, R (C::*handler) (const sf::HostId &, const P &, const sf::ByteView & )>\n"
+						"struct RpcViewInvoker {\n"
+						"\tstatic bool invoke (C * instance, const typename C::RpcCall & call, const P & p) {\n"
+						"\t\treturn RpcResult<R>::call (handler, instance, *call.sender, p, call.data);\n"
+						"\t}\n"
+						"};\n\n");
+
+	// Call functions, necessary to call the final member function via a function pointer
+	// As a template it can also circumvent visibility problems.
+	fprintf (mOutput, "template <class C, class P, class Invoker>\n"
+			        	"\tstatic bool callRpcHandler (C * instance, const typename C::RpcCall & call){\n"
+						"\tP p;\n"
+						"\tbool suc = p.deserialize (*call.header);\n"
+						"\tif (!suc) return false;\n"
+						"\treturn Invoker::invoke (instance, call, p);\n"
+						"}\n\n");
+
+	if (reuse) {
+		// Variant reusing one thread local parameter object for all calls, deserialized in place
+		// (keeping the storage of its containers). Falls back to a fresh object if the handler recursively calls the same command.
+		// The busy flag is reset by a guard, so a throwing handler does not disable the reuse for its thread.
+		fprintf (mOutput, "template <class P> struct RpcReusedParameter {\n"
+							"\tRpcReusedParameter () : busy (false) {}\n"
+							"\tstruct Guard {\n"
+							"\t\tGuard (bool & busy) : busy (busy) { busy = true; }\n"
+							"\t\t~Guard () { busy = false; }\n"
+							"\t\tbool & busy;\n"
+							"\t};\n"
+							"\tP p;\n"
+							"\tbool busy;\n"
+							"};\n\n");
+		fprintf (mOutput, "template <class C, class P, class Invoker>\n"
+							"\tstatic bool callRpcReuseHandler (C * instance, const typename C::RpcCall & call){\n"
+							"\tstatic boost::thread_specific_ptr<RpcReusedParameter<P> > reused;\n"
+							"\tRpcReusedParameter<P> * slot = reused.get ();\n"
+							"\tif (!slot) {\n"
+							"\t\tslot = new RpcReusedParameter<P> ();\n"
+							"\t\treused.reset (slot);\n"
+							"\t}\n"
+							"\tif (slot->busy) return callRpcHandler<C,P,Invoker> (instance, call);\n"
+							"\tbool suc;\n"
+							"\t{\n"
+							"\t\tsf::DeserializationScope scope (sf::DeserializationContext::current().pool, true);\n"
+							"\t\tsuc = slot->p.deserialize (*call.header);\n"
+							"\t}\n"
+							"\tif (!suc) return false;\n"
+							"\ttypename RpcReusedParameter<P>::Guard guard (slot->busy);\n"
+							"\treturn Invoker::invoke (instance, call, slot->p);\n"
+							"}\n\n");
+	}
+
+	// Batch variant, the parameter object is reused for all calls and deserialized in place
+	// (generated deserializers set all members)
+	fprintf (mOutput, "template <class C, class P, class Invoker>\n"
+			        	"\tstatic int callRpcBatchHandler (C * instance, const typename C::RpcCall * calls, const size_t * indices, size_t count, bool * results){\n"
+						"\tP p;\n"
+						"\tint handled = 0;\n"
+						"\tfor (size_t i = 0; i < count; i++) {\n"
+						"\t\tconst typename C::RpcCall & call = calls[indices[i]];\n"
+						"\t\tbool suc = !call.header->error();\n"
+						"\t\tif (suc) {\n"
+						"\t\t\tsf::DeserializationScope scope (sf::DeserializationContext::current().pool, true);\n"
+						"\t\t\tsuc = p.deserialize (*call.header);\n"
+						"\t\t}\n"
+						"\t\tsuc = suc && Invoker::invoke (instance, call, p);\n"
+						"\t\tif (suc) handled++;\n"
+						"\t\tif (results) results[indices[i]] = suc;\n"
+						"\t}\n"
+						"\treturn handled;\n"
+						"}\n\n");
+	fprintf (mOutput, "} // namespace detail\n} // namespace sf\n\n");
 	return CppGeneratorBase::generate (tree);
 }
 
 
 bool RpcGenerator::handleClassUp (const ClassElement * e) {
 	if (!CppGeneratorBase::handleClassUp(e)) return false;
-	if (!e->commands.count ("RPC")) return true; // nothing to do
+	bool reuse = e->commands.count ("RPC_REUSE") > 0;
+	if (!(e->commands.count ("RPC") || reuse)) return true; // nothing to do
 
-	typedef std::vector<std::string> RpcFuncVector;
+	typedef std::vector<RpcFunc> RpcFuncVector;
 	RpcFuncVector rpcFuncs;
 	// Scanning for onRpc methods.
 	for (ClassElement::ChildrenVec::const_iterator i = e->children.begin(); i != e->children.end(); i++) {
@@ -27,9 +142,9 @@ bool RpcGenerator::handleClassUp (const ClassElement * e) {
 		if (element->type == StackElement::FunctionDeclaration){
 			if (element->name.substr (0, 5) == "onRpc") {
 				FunctionDeclarationElement * func = static_cast<FunctionDeclarationElement*> (element);
-				std::string type;
-				if (!checkRpcFuncArguments (func, &type)) continue;
-				rpcFuncs.push_back (type);
+				RpcFunc rpcFunc;
+				if (!checkRpcFuncArguments (func, &rpcFunc)) continue;
+				rpcFuncs.push_back (rpcFunc);
 			}
 		}
 	}
@@ -46,55 +161,92 @@ bool RpcGenerator::handleClassUp (const ClassElement * e) {
 	// Generate commands ()
 	fprintf (mOutput, "const char * g%s_commands[] = {\n", e->name.c_str());
 	for (RpcFuncVector::const_iterator i = rpcFuncs.begin(); i != rpcFuncs.end(); i++) {
-		fprintf (mOutput, "\t\"%s\",\n", SerializationGenerator::commandName (*i).c_str());
+		fprintf (mOutput, "\t\"%s\",\n", SerializationGenerator::commandName (i->type).c_str());
 	}
 	fprintf (mOutput, "\t0\n};\n\n");
 	fprintf (mOutput, "const char ** %scommands () const {\n", classScope().c_str());
 	fprintf (mOutput, "\treturn g%s_commands;\n", e->name.c_str());
 	fprintf (mOutput, "}\n\n");
 
-	// Call function, necessary to call the final member function via a function pointer
-	// As a template it can also circumvent visibility problems.
-	fprintf (mOutput, "template <class C, class P, void (C::*handler) (const sf::HostId &, const P &, const sf::ByteArray & )>\n"
-			        	"\tstatic bool callRpcHandler (C * instance, const sf::HostId & sender, const sf::Deserialization & header, const sf::ByteArray & data){\n"
-						"\tP p;\n"
-						"\tbool suc = p.deserialize (header);\n"
-						"\tif (!suc) return false;\n"
-						"\t(instance->*handler) (sender, p, data);\n"
-						"\treturn true;\n"
-						"}\n\n");
-
-	// Generate handleRpc () method with hash table search
-	// Values are function pointers to callRpcHandler instantiations
+	// Generate rpcCommandIndex () with perfect hash search over static tables
 	StaticHashTableBuilder builder;
+	int index = 0;
+	for (RpcFuncVector::const_iterator i = rpcFuncs.begin(); i != rpcFuncs.end(); i++) {
+		char buffer [32];
+		snprintf (buffer, sizeof (buffer), "%d", index++);
+		builder.add (SerializationGenerator::commandName (i->type), buffer);
+	}
+	fprintf (mOutput, "int %srpcCommandIndex (const char * key, size_t length) {\n", classScope().c_str());
+	if (!builder.generatePerfectHashCode (mOutput, "int", "length")) {
+		fprintf (stderr, "Could not generate RPC dispatch table for %s (duplicate commands?)\n", e->name.c_str());
+		return false;
+	}
+	fprintf (mOutput, "\treturn foundKey ? value : -1;\n");
+	fprintf (mOutput, "}\n\n");
+
+	// Generate handleRpc (), values are function pointers to callRpcHandler instantiations
+	fprintf (mOutput, "bool %shandleRpc (const RpcCall & call) {\n", classScope().c_str());
+	fprintf (mOutput, "\tif (call.header->error()) return false;\n");
+	fprintf (mOutput, "\ttypedef bool (*Handler) (%s *, const RpcCall &);\n", e->name.c_str());
+	fprintf (mOutput, "\tstatic const Handler handlers[] = {\n");
+	for (RpcFuncVector::const_iterator i = rpcFuncs.begin(); i != rpcFuncs.end(); i++) {
+		fprintf (mOutput, "\t\t%s&%s<%s,%s,%s >\n", i == rpcFuncs.begin() ? "" : ",", reuse ? "sf::detail::callRpcReuseHandler" : "sf::detail::callRpcHandler", e->name.c_str(), i->type.c_str(), invoker (e->name, *i).c_str());
+	}
+	fprintf (mOutput, "\t};\n");
+	fprintf (mOutput, "\tint index = rpcCommandIndex (call.cmd->c_str(), call.cmd->size());\n");
+	fprintf (mOutput, "\tif (index < 0) return false;\n");
+	fprintf (mOutput, "\treturn handlers[index] (this, call);\n");
+	fprintf (mOutput, "}\n\n");
+
+	// Generate handleRpcBatch (), calls are grouped by command (counting sort, stable)
+	// and each group is handled by a callRpcBatchHandler instantiation
+	fprintf (mOutput, "int %shandleRpcBatch (const RpcCall * calls, size_t count, bool * results) {\n", classScope().c_str());
+	fprintf (mOutput, "\ttypedef int (*BatchHandler) (%s *, const RpcCall *, const size_t *, size_t, bool *);\n", e->name.c_str());
+	fprintf (mOutput, "\tstatic const BatchHandler handlers[] = {\n");
 	for (RpcFuncVector::const_iterator i = rpcFuncs.begin(); i != rpcFuncs.end(); i++) {
-		char buffer [1024];
-		buffer [1023] = 0;
-		snprintf (buffer, 1023, "&callRpcHandler<%s,%s,&%s::onRpc>", e->name.c_str(), i->c_str(), e->name.c_str());
-		builder.add (SerializationGenerator::commandName (*i), buffer);
-	}
-
-
-	fprintf (mOutput, "bool %shandleRpc (const sf::HostId & sender, const sf::String & cmd, const sf::Deserialization & header, const sf::ByteArray & data) {\n", classScope().c_str());
-	fprintf (mOutput, "\tif (header.error()) return false;\n");
-	fprintf (mOutput, "\tconst char * key = cmd.c_str();\n");
-	fprintf (mOutput, "\ttypedef bool (*ValueType) (%s *, const sf::HostId &, const sf::Deserialization &, const sf::ByteArray &);\n", e->name.c_str());
-	builder.generateHashCode (mOutput, "ValueType");
-	fprintf (mOutput, "\tif (!foundKey) return false;\n");
-	fprintf (mOutput, "\tvalue (this, sender, header, data);\n\n");
-	fprintf (mOutput, "\treturn true;\n");
-	fprintf (mOutput, "}\n");
+		fprintf (mOutput, "\t\t%s&sf::detail::callRpcBatchHandler<%s,%s,%s >\n", i == rpcFuncs.begin() ? "" : ",", e->name.c_str(), i->type.c_str(), invoker (e->name, *i).c_str());
+	}
+	fprintf (mOutput, "\t};\n");
+	fprintf (mOutput, "\tconst int commandCount = %d;\n", (int) rpcFuncs.size());
+	fprintf (mOutput,
+			"\t// group 0 contains unknown commands\n"
+			"\tstd::vector<int> group (count);\n"
+			"\tsize_t groupBegin [commandCount + 2] = {0};\n"
+			"\tfor (size_t i = 0; i < count; i++) {\n"
+			"\t\tconst sf::String & cmd = *calls[i].cmd;\n"
+			"\t\tgroup[i] = rpcCommandIndex (cmd.c_str(), cmd.size()) + 1;\n"
+			"\t\tgroupBegin[group[i] + 1]++;\n"
+			"\t}\n"
+			"\tfor (int g = 1; g <= commandCount + 1; g++) groupBegin[g] += groupBegin[g - 1];\n"
+			"\tstd::vector<size_t> order (count);\n"
+			"\tsize_t fill [commandCount + 1];\n"
+			"\tfor (int g = 0; g <= commandCount; g++) fill[g] = groupBegin[g];\n"
+			"\tfor (size_t i = 0; i < count; i++) order[fill[group[i]]++] = i;\n"
+			"\tif (results) {\n"
+			"\t\tfor (size_t i = groupBegin[0]; i < groupBegin[1]; i++) results[order[i]] = false;\n"
+			"\t}\n"
+			"\tint handled = 0;\n"
+			"\tfor (int c = 0; c < commandCount; c++) {\n"
+			"\t\tsize_t n = groupBegin[c + 2] - groupBegin[c + 1];\n"
+			"\t\tif (n > 0) handled += handlers[c] (this, calls, &order[groupBegin[c + 1]], n, results);\n"
+			"\t}\n"
+			"\treturn handled;\n"
+			"}\n\n");
 	return true;
 }
 
-bool RpcGenerator::checkRpcFuncArguments (const FunctionDeclarationElement * func, std::string * typeName) {
+std::string RpcGenerator::invoker (const std::string & className, const RpcFunc & func) {
+	return std::string (func.viewPayload ? "sf::detail::RpcViewInvoker<" : "sf::detail::RpcArrayInvoker<") + className + "," + func.type + "," + func.returnType + ",&" + className + "::onRpc>";
+}
+
+bool RpcGenerator::checkRpcFuncArguments (const FunctionDeclarationElement * func, RpcFunc * rpcFunc) {
 	if (func->arguments.size() != 3) {
 		fprintf (stderr, "Warning: did found a rpc like function with wrong argument count: %s\n", sf::toJSON (func).c_str());
 		return false;
 	}
-	if (func->returnType.name != "void") {
-		fprintf (stderr, "Warning: Return type of rpc like function will be ignored: %s!", sf::toJSON (func).c_str());
-		// can stil continue
+	if (func->returnType.static_ || func->returnType.name.empty()) {
+		fprintf (stderr, "Error: rpc like function must be a non-static member function: %s\n", sf::toJSON (func).c_str());
+		return false;
 	}
 	if (!(/*func->arguments[0].type.name == "HostId &" &&*/ func->arguments[0].type.const_)){
 		fprintf (stderr, "Error: 1st argument %s doesn't fit: %s\n", sf::toJSON (func).c_str(), sf::toJSON (func->arguments[0]).c_str());
@@ -113,11 +265,16 @@ bool RpcGenerator::checkRpcFuncArguments (const FunctionDeclarationElement * fun
 		fprintf (stderr, "Error: Type of 2nd argument doesn't fit: const %s\n", type.c_str());
 		return false;
 	}
-	*typeName = type.substr (0, type.length() - 2);
-	if (typeName->find(" ") != typeName->npos || typeName->find (" ") != typeName->npos){
-		fprintf (stderr, "Warning: Type of 2nd argument looks strange: %s\n", typeName->c_str());
+	std::string typeName = type.substr (0, type.length() - 2);
+	if (typeName.find(" ") != typeName.npos || typeName.find (" ") != typeName.npos){
+		fprintf (stderr, "Warning: Type of 2nd argument looks strange: %s\n", typeName.c_str());
 		return false;
 	}
+	rpcFunc->type = typeName;
+	// void and bool are synchronous, everything else is handed off to sf::RpcAsyncTraits
+	rpcFunc->returnType = (func->returnType.const_ ? "const " : "") + func->returnType.name;
+	// payload is passed as ByteView (without copying) or as ByteArray
+	rpcFunc->viewPayload = func->arguments[2].type.name.find ("ByteView") != std::string::npos;
 	return true;
 }
 
@@ -3,17 +3,31 @@
 
 /// A generator for RPC-capable objects
 /// like used in project Schneeflocke.
-/// Used command: SF_AUTOREFLECT_RPC
+/// Used command: SF_AUTOREFLECT_RPC or SF_AUTOREFLECT_RPC_REUSE
+/// (handleRpc reuses one thread local parameter object per command, deserialized in place)
 /// Will generate
 /// - const char ** commands () returns all accepted commands
 /// - const char * name() will return class name
 ///
 ///   // handles an RPC Command; Returns true on success (accepted command, correct parsing)
 /// - bool handleRpc (const HostId & sender, const String & cmdName, const Deserialization & header, const ByteArray & data)
+///   (also available without payload, with a ByteView payload or with an RpcCall describing the call)
+///
+///   // handles many RPC Commands at once; calls are grouped by command (keeping their order within a command)
+///   // and one parameter object is reused per command. Returns number of successfully handled calls.
+/// - int handleRpcBatch (const RpcCall * calls, size_t count, bool * results = 0)
+/// - static int rpcCommandIndex (const char * cmd, size_t length) returns index in commands () or -1
 /// All methods who want to be reachable do have to have the following signature
 /// void onRpc (const HostId & source, const T & cmd, const ByteArray & data);
+/// or (receiving the payload without copying it)
+/// void onRpc (const HostId & source, const T & cmd, const ByteView & data);
 /// where T is an structure which can be used as a a command (implements serialize/deserialize/cmdName)
 /// the cmdName of T must be like SerializationGenerator::commandName of T. (E.g. RequestReply --> Command name is requestReply).
+/// The handler may also return
+/// - bool: the result of handleRpc (false if the handler rejects the call)
+/// - any other type R (a future, a task handle, ...): an asynchronous result, which is passed
+///   to sf::RpcAsyncTraits<R>::handOff (which must be specialized for R) and handleRpc returns true immediately. Arguments are only
+///   valid during the call, asynchronous handlers must copy what they need later.
 ///
 /// Warning: this class is highly special for Schneeflocke and subject of further changes.
 class RpcGenerator : public CppGeneratorBase {
@@ -30,6 +44,17 @@ protected:
 	// override
 	virtual bool handleClassUp (const ClassElement * e);
 
-	// check if rpc function fits, typeName is type name of 2nd argument
-	bool checkRpcFuncArguments (const FunctionDeclarationElement * func, std::string * typeName);
+	/// An onRpc function
+	struct RpcFunc {
+		RpcFunc () : viewPayload (false) {}
+		std::string type;	///< type name of 2nd argument
+		std::string returnType;	///< return type (void, bool or an asynchronous result)
+		bool viewPayload;	///< 3rd argument is a ByteView (instead of ByteArray)
+	};
+
+	// check if rpc function fits
+	bool checkRpcFuncArguments (const FunctionDeclarationElement * func, RpcFunc * rpcFunc);
+
+	// returns the Invoker template instantiation passing the payload to func
+	static std::string invoker (const std::string & className, const RpcFunc & func);
 };
@@ -1,5 +1,6 @@
 #include "SerializationGenerator.h"
 #include <stdio.h>
+#include <sfserialization/JSONParser.h>
 
 bool SerializationGenerator::generate (const RootElement * tree) {
 	StackElement::CommandSet commands = tree->subCommands ();
@@ -14,7 +15,9 @@ bool SerializationGenerator::generate (const RootElement * tree) {
 
 	fprintf (mOutput,
 			"#include <sfserialization/Serialization.h>\n"
-			"#include <sfserialization/Deserialization.h>\n");
+			"#include <sfserialization/Deserialization.h>\n"
+			"#include <sfserialization/BinarySerialization.h>\n"
+			"#include <sfserialization/BinaryDeserialization.h>\n");
 	return CppGeneratorBase::generate (tree);
 }
 
@@ -38,12 +41,19 @@ bool SerializationGenerator::handleClassUp (const ClassElement * e) {
 
 	bool isDefault = serial;
 	bool getCmdName = e->commands.count ("GETCMDNAME") > 0 || e->commands.count ("SDC");
-	if (serial || deserial) fprintf (mOutput, "\n"); // nicer
+	std::vector<int> fieldIds;
+	if (serial || deserial) {
+		fprintf (mOutput, "\n"); // nicer
+		if (!assignFieldIds (e, &fieldIds)) return false;
+	}
 	if (serial) {
-		bool v = generateSerializer (e); if (!v) return false;
+		bool v = generateSerializer (e, "sf::Serialization"); if (!v) return false;
+		v = generateSerializer (e, "sf::BinarySerialization", &fieldIds); if (!v) return false;
 	}
 	if (deserial){
-		bool v = generateDeserializer (e); if (!v) return false;
+		bool v = generateDeserializer (e, "sf::Deserialization"); if (!v) return false;
+		v = generateDeserializer (e, "sf::BinaryDeserialization", &fieldIds); if (!v) return false;
+		v = generateMemberName (e); if (!v) return false;
 	}
 	if (isDefault) {
 		bool v = generateIsDefault (e); if (!v) return false;
@@ -54,15 +64,54 @@ bool SerializationGenerator::handleClassUp (const ClassElement * e) {
 	return true;
 }
 
-bool SerializationGenerator::generateSerializer (const ClassElement * element) {
-	fprintf (mOutput, "void %sserialize (sf::Serialization& _serialization) const {\n", classScope().c_str());
+/*static*/ bool SerializationGenerator::assignFieldIds (const ClassElement * element, std::vector<int> * ids) {
+	ids->clear ();
+	std::set<int> used;
+	int position = 0;
+	for (ClassElement::MemberVariableVec::const_iterator i = element->memberVariables.begin(); i != element->memberVariables.end(); i++){
+		if (i->first == Private) continue;
+		position++;
+		ClassElement::FieldIdMap::const_iterator j = element->fieldIds.find (i->second.name);
+		int id = j == element->fieldIds.end() ? position : j->second;
+		if (!used.insert (id).second) {
+			fprintf (stderr, "Error: Duplicated field id %d in %s (member %s), set it with SF_AUTOREFLECT_FIELDID\n", id, element->name.c_str(), i->second.name.c_str());
+			return false;
+		}
+		ids->push_back (id);
+	}
+	for (ClassElement::FieldIdMap::const_iterator i = element->fieldIds.begin(); i != element->fieldIds.end(); i++){
+		bool found = false;
+		for (ClassElement::MemberVariableVec::const_iterator j = element->memberVariables.begin(); j != element->memberVariables.end(); j++){
+			if (j->first != Private && j->second.name == i->first) found = true;
+		}
+		if (!found) {
+			fprintf (stderr, "Error: Field id set for unknown member %s in %s\n", i->first.c_str(), element->name.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SerializationGenerator::generateSerializer (const ClassElement * element, const char * serializationType, const std::vector<int> * fieldIds) {
+	fprintf (mOutput, "void %sserialize (%s& _serialization) const {\n", classScope().c_str(), serializationType);
+	int base = 0;
 	for (ClassElement::ParentVec::const_iterator i = element->parents.begin(); i != element->parents.end(); i++){
 		if (i->first != Private){
-			fprintf (mOutput, "\t%s::serialize(_serialization);\n", i->second.c_str());
+			if (fieldIds) {
+				fprintf (mOutput, "\t_serialization.beginBase (%d);\n", base++);
+				fprintf (mOutput, "\t%s::serialize(_serialization);\n", i->second.c_str());
+				fprintf (mOutput, "\t_serialization.endBase ();\n");
+			} else {
+				fprintf (mOutput, "\t%s::serialize(_serialization);\n", i->second.c_str());
+			}
 		}
 	}
+	int field = 0;
 	for (ClassElement::MemberVariableVec::const_iterator i = element->memberVariables.begin(); i != element->memberVariables.end(); i++){
-		if (i->first != Private)
+		if (i->first == Private) continue;
+		if (fieldIds)
+			fprintf (mOutput, "\t_serialization (%d, \"%s\", %s);\n", (*fieldIds)[field++], i->second.name.c_str(), i->second.name.c_str());
+		else
 			fprintf (mOutput, "\t_serialization (\"%s\", %s);\n", i->second.name.c_str(), i->second.name.c_str());
 	}
 	fprintf (mOutput, "}\n\n");
@@ -87,6 +136,25 @@ bool SerializationGenerator::generateIsDefault (const ClassElement * element) {
 	return true;
 }
 
+bool SerializationGenerator::generateMemberName (const ClassElement * element) {
+	fprintf (mOutput, "const char* %smemberName (const void * _member) const {\n", classScope().c_str());
+	for (ClassElement::MemberVariableVec::const_iterator i = element->memberVariables.begin(); i != element->memberVariables.end(); i++){
+		if (i->first != Private)
+			fprintf (mOutput, "\tif (_member == &%s) return \"%s\";\n", i->second.name.c_str(), i->second.name.c_str());
+	}
+	bool hasParents = false;
+	for (ClassElement::ParentVec::const_iterator i = element->parents.begin(); i != element->parents.end(); i++){
+		if (i->first != Private){
+			if (!hasParents) fprintf (mOutput, "\tconst char * _name;\n");
+			hasParents = true;
+			fprintf (mOutput, "\tif ((_name = %s::memberName (_member))) return _name;\n", i->second.c_str());
+		}
+	}
+	fprintf (mOutput, "\treturn 0;\n");
+	fprintf (mOutput, "}\n\n");
+	return true;
+}
+
 bool SerializationGenerator::generateGetCmdName (const ClassElement * element) {
 	fprintf (mOutput, "const char* %sgetCmdName () {\n", classScope().c_str());
 	fprintf (mOutput, "\treturn \"%s\";\n", commandName (element->name).c_str());
@@ -95,17 +163,29 @@ bool SerializationGenerator::generateGetCmdName (const ClassElement * element) {
 }
 
 
-bool SerializationGenerator::generateDeserializer (const ClassElement * element) {
-	fprintf (mOutput, "bool %sdeserialize (const sf::Deserialization& _deserialization){\n", classScope().c_str());
+bool SerializationGenerator::generateDeserializer (const ClassElement * element, const char * deserializationType, const std::vector<int> * fieldIds) {
+	fprintf (mOutput, "bool %sdeserialize (const %s& _deserialization){\n", classScope().c_str(), deserializationType);
 	fprintf (mOutput, "\tbool suc = true;\n");
+	int base = 0;
 	for (ClassElement::ParentVec::const_iterator i = element->parents.begin(); i != element->parents.end(); i++){
 		if (i->first != Private){
-			fprintf (mOutput, "\tsuc=%s::deserialize(_deserialization) && suc;\n", i->second.c_str());
+			if (fieldIds)
+				fprintf (mOutput, "\tsuc=%s::deserialize(%s (_deserialization, %d)) && suc;\n", i->second.c_str(), deserializationType, base++);
+			else
+				fprintf (mOutput, "\tsuc=%s::deserialize(_deserialization) && suc;\n", i->second.c_str());
 		}
 	}
+	int field = 0;
 	for (ClassElement::MemberVariableVec::const_iterator i = element->memberVariables.begin(); i != element->memberVariables.end(); i++){
-		if (i->first != Private)
-			fprintf (mOutput, "\tsuc = _deserialization (\"%s\", %s) && suc;\n", i->second.name.c_str(), i->second.name.c_str());
+		if (i->first == Private) continue;
+		if (fieldIds)
+			fprintf (mOutput, "\tsuc = _deserialization (%d, \"%s\", %s) && suc;\n", (*fieldIds)[field++], i->second.name.c_str(), i->second.name.c_str());
+		else {
+			// key with precalculated length and hash, the lookup compares the hashes first
+			const std::string & name = i->second.name;
+			fprintf (mOutput, "\tsuc = _deserialization (sf::json::Key (\"%s\", %d, 0x%08xu), %s) && suc;\n",
+					name.c_str(), (int) name.length(), (unsigned int) sf::json::keyHash (name.c_str(), (int) name.length()), name.c_str());
+		}
 	}
 	fprintf (mOutput, "\treturn suc;\n");
 	fprintf (mOutput, "}\n\n");
@@ -25,16 +25,28 @@ protected:
 	virtual bool handleClassUp (const ClassElement * e);
 
 private:
+	/// Assigns the field ids of the (non private) member variables, used by the binary format.
+	/// Ids come from SF_AUTOREFLECT_FIELDID or the position in declaration order (starting with 1).
+	/// @return false on duplicated ids
+	static bool assignFieldIds (const ClassElement * element, std::vector<int> * ids);
+
 	/// (In class type, as a member function)
-	bool generateSerializer (const ClassElement * element);
+	/// serializationType is sf::Serialization or sf::BinarySerialization
+	/// If fieldIds is given, they are passed to the serialization together with the key names
+	bool generateSerializer (const ClassElement * element, const char * serializationType, const std::vector<int> * fieldIds = 0);
 
 	/// Generates isDefault() functions
 	bool generateIsDefault (const ClassElement * element);
 
+	/// Generates memberName() function (member address to key name)
+	bool generateMemberName (const ClassElement * element);
+
 	/// Generate type name function
 	bool generateGetCmdName (const ClassElement * element);
 
 	/// Generates deserializer functions (SERIAL)
 	/// (In class type, as a member function)
-	bool generateDeserializer (const ClassElement * element);
+	/// deserializationType is sf::Deserialization or sf::BinaryDeserialization
+	/// If fieldIds is given, they are passed to the deserialization together with the key names
+	bool generateDeserializer (const ClassElement * element, const char * deserializationType, const std::vector<int> * fieldIds = 0);
 };
@@ -1,104 +1,102 @@
 #include "StaticHashTableBuilder.h"
 #include <assert.h>
+#include <algorithm>
 
 void StaticHashTableBuilder::add (const std::string & key, const std::string & value) {
-	sf::HashValue h = sf::hash ((unsigned char*) key.c_str());
-	mHashes.push_back (HashPair (KeyValue (key, value), h));
+	mKeys.push_back (KeyValue (key, value));
 }
 
-bool StaticHashTableBuilder::generateHashCode (FILE * out, const std::string& typeName) {
-	if (mHashes.empty()) return false;
-	int mod = calcBestModulus();
-	HashTable table;
-	calcHashTable(mod, &table);
+bool StaticHashTableBuilder::generatePerfectHashCode (FILE * out, const std::string & typeName, const std::string & lengthExpression) {
+	if (mKeys.empty()) return false;
+	PerfectHash hash;
+	if (!calcPerfectHash (&hash)) return false;
+	const char * type = typeName.c_str();
+	const char * length = lengthExpression.c_str();
 
-	// Lookup structure
-	fprintf (out, "\t// hash table lookup structure\n");
-	fprintf (out, "\tconst int hashTable[] = {0");
-	{
-		int current     = table[0].size() + 1; // + null element
-		int nullElement = table[0].size();
-		for (int i = 1; i < mod; i++) {
-			if (table[i].empty()){
-				fprintf (out, ", %d", nullElement); // just point to null element
-			} else {
-				fprintf (out, ", %d", current);     // full entry.
-				current+=table[i].size() + 1;
-			}
-		}
-		fprintf (out, "};\n");
+	fprintf (out, "\t// perfect hash tables\n");
+	fprintf (out, "\tstatic const uint32_t seeds[] = {");
+	for (size_t i = 0; i < hash.seeds.size(); i++) {
+		fprintf (out, "%s%u", i == 0 ? "" : ", ", (unsigned int) hash.seeds[i]);
 	}
-
-	// Table
-	fprintf (out, "\t// hash table\n");
-	fprintf (out, "\tstruct HashEntry { const char * name; %s value; };\n", typeName.c_str());
-	fprintf (out, "\tconst HashEntry entries[] = {\n");
-	bool firstOutElement = true;
-	bool firstInElement  = true;
-	for (HashTable::const_iterator i = table.begin(); i != table.end(); i++){
-		if (!firstInElement && i->empty()) continue;
-		for (std::vector<StaticHashTableBuilder::KeyValue>::const_iterator j = i->begin(); j != i->end(); j++){
-			fprintf (out, "\t\t");
-			if (!firstOutElement) { fprintf (out, ","); }
-			firstOutElement = false;
-			fprintf (out, "{\"%s\", %s}\n", j->first.c_str(), j->second.c_str());
-		}
+	fprintf (out, "};\n");
+	fprintf (out, "\tstruct HashEntry { const char * name; size_t length; %s value; };\n", type);
+	fprintf (out, "\tstatic const HashEntry entries[] = {\n");
+	for (size_t i = 0; i < hash.slots.size(); i++) {
 		fprintf (out, "\t\t");
-		if (!firstOutElement) { fprintf (out, ","); }
-		firstOutElement = false;
-		fprintf (out, "{0, %s()}\n", typeName.c_str());
-		firstInElement = false;
+		if (i > 0) fprintf (out, ",");
+		if (hash.slots[i] < 0) {
+			fprintf (out, "{0, 0, %s()}\n", type);
+		} else {
+			const KeyValue & kv = mKeys[hash.slots[i]];
+			fprintf (out, "{\"%s\", %d, %s}\n", kv.first.c_str(), (int) kv.first.length(), kv.second.c_str());
+		}
 	}
 	fprintf (out, "\t};\n");
 
-	// Lookup function
+	// Lookup
 	fprintf (out, "\t// lookup\n");
-	fprintf (out, "\t%s value;\n", typeName.c_str());
+	fprintf (out, "\t%s value = %s();\n", type, type);
 	fprintf (out, "\tbool foundKey = false;\n");
-	fprintf (out, "\tint hashCode = sf::hash ((unsigned char*) key) %% %d;\n", mod);
-	fprintf (out, "\tconst HashEntry * entry = entries + hashTable[hashCode];\n");
-	fprintf (out, "\twhile (entry->name != 0){\n");
-	fprintf (out, "\t\tif(strcmp (entry->name, key) == 0) {value = entry->value; foundKey = true; break; }\n");
-	fprintf (out, "\t\tentry++;\n");
-	fprintf (out, "\t}\n");
+	fprintf (out, "\tuint32_t bucket = sf::hashSeeded (key, %s, 0) %% %d;\n", length, (int) hash.seeds.size());
+	fprintf (out, "\tconst HashEntry & entry = entries[sf::hashSeeded (key, %s, seeds[bucket]) %% %d];\n", length, (int) hash.slots.size());
+	fprintf (out, "\tif (entry.name && entry.length == %s && memcmp (entry.name, key, %s) == 0) { value = entry.value; foundKey = true; }\n", length, length);
 	return true;
 }
 
-int StaticHashTableBuilder::calcBestModulus (){
-	int bestPrice  = price (1);
-	int bestMod    = 1;
-	for (size_t i = 2; i < 3 * mHashes.size(); i++){
-		int p = price (i);
-		if (p < bestPrice){
-			bestPrice = p;
-			bestMod   = i;
-		}
+bool StaticHashTableBuilder::calcPerfectHash (PerfectHash * out) const {
+	int n = (int) mKeys.size();
+	// try a minimal table first, bigger ones make it easier to find seeds
+	for (int slots = n; slots <= 4 * n; slots += n / 4 + 1) {
+		if (calcPerfectHash (slots, out)) return true;
 	}
-	return bestMod;
+	return false;
 }
 
-void StaticHashTableBuilder::calcHashTable (int mod, HashTable * out) {
-	assert (out);
-	out->clear();
-	out->resize (mod);
-	for (StringHashes::const_iterator i = mHashes.begin(); i != mHashes.end(); i++){
-		int m = i->second % mod;
-		((*out)[m]).push_back (i->first);
-	}
-}
+bool StaticHashTableBuilder::calcPerfectHash (int slotCount, PerfectHash * out) const {
+	const uint32_t maxSeed = 100000;
+	int n = (int) mKeys.size();
+	int bucketCount = n / 4 + 1;
 
-
-int StaticHashTableBuilder::countCollisions (int mod){
-	std::vector<int> counts (mod, int());
-	counts.resize(mod);
-	for (StringHashes::const_iterator i = mHashes.begin(); i != mHashes.end(); i++){
-		int h = i->second % mod;
-		// fprintf (stderr, "i->second: %d --> %d = ", (int) i->second, (int) h);
-		counts[h]++;
+	// 1st level: distribute keys into buckets
+	std::vector<std::vector<int> > buckets (bucketCount);
+	for (int i = 0; i < n; i++) {
+		const std::string & key = mKeys[i].first;
+		buckets[sf::hashSeeded (key.c_str(), key.length(), 0) % bucketCount].push_back (i);
 	}
-	int result = 0;
-	for (std::vector<int>::const_iterator i = counts.begin(); i != counts.end(); i++){
-		if ( (*i) > 1 ) result += (*i - 1);
+	// 2nd level: find a seed for each bucket which places all its keys into free slots, biggest buckets first
+	std::vector<std::pair<int, int> > order; // (-size, bucket)
+	for (int b = 0; b < bucketCount; b++) {
+		order.push_back (std::make_pair (-(int) buckets[b].size(), b));
 	}
-	return result;
+	std::sort (order.begin(), order.end());
+
+	out->seeds.assign (bucketCount, 0);
+	out->slots.assign (slotCount, -1);
+	std::vector<int> positions;
+	for (size_t o = 0; o < order.size(); o++) {
+		const std::vector<int> & bucket = buckets[order[o].second];
+		if (bucket.empty()) break;
+		bool placed = false;
+		for (uint32_t seed = 1; seed < maxSeed && !placed; seed++) {
+			positions.clear ();
+			placed = true;
+			for (size_t k = 0; k < bucket.size(); k++) {
+				const std::string & key = mKeys[bucket[k]].first;
+				int p = sf::hashSeeded (key.c_str(), key.length(), seed) % slotCount;
+				if (out->slots[p] >= 0 || std::find (positions.begin(), positions.end(), p) != positions.end()) {
+					placed = false;
+					break;
+				}
+				positions.push_back (p);
+			}
+			if (placed) {
+				out->seeds[order[o].second] = seed;
+				for (size_t k = 0; k < bucket.size(); k++) {
+					out->slots[positions[k]] = bucket[k];
+				}
+			}
+		}
+		if (!placed) return false;
+	}
+	return true;
 }
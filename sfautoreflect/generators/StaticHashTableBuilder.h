@@ -4,41 +4,37 @@
 #include <vector>
 #include <stdio.h>
 
-/// Tool class which generates a static hash table for storing strings
-/// Hashing is done via sf::hash function
+/// Tool class which generates a static (perfect) hash table for storing strings
+/// Hashing is done via sf::hashSeeded function
 class StaticHashTableBuilder {
 public:
 	typedef std::pair< std::string, std::string  > KeyValue;
-	typedef std::vector<std::vector<KeyValue> > HashTable;
 
 	/// 1. Initialization - add values
 	void add (const std::string & key, const std::string & value);
 
-	/// 2. Automatically generate C++ code for hash table (calls calsBestModulus and calcHashTable for you)
-	/// Returns true on success
-	/// In-variable must be called const char * key.
+	/// 2. Generates C++ code for a lookup with a perfect hash (static tables, exactly one string compare)
+	/// In-variable must be called const char * key, its length is given by lengthExpression.
 	/// Out variable will be called TypeName value.
 	/// Success of lookup will be stored in bool foundKey.
-	bool generateHashCode (FILE * out, const std::string& typeName);
+	/// Returns true on success
+	bool generatePerfectHashCode (FILE * out, const std::string & typeName, const std::string & lengthExpression);
 
-	/// Calc (guess) best modolus for current hash values
-	int calcBestModulus ();
+	/// A perfect hash (hash and displace): a key is at
+	/// slot hashSeeded (key, seeds[hashSeeded (key, 0) % seeds.size()]) % slots.size()
+	struct PerfectHash {
+		std::vector<uint32_t> seeds;	///< Seed for each bucket
+		std::vector<int> slots;			///< Index of the key for each slot (-1 if empty)
+	};
 
-	/// Calculates the final hash table
-	void calcHashTable (int mod, HashTable * out);
+	/// Calculates a perfect hash for the added keys, returns false if there is none (e.g. duplicate keys)
+	bool calcPerfectHash (PerfectHash * out) const;
 
 private:
 
-	/// Counts number of collisions for a given modulus
-	int countCollisions (int mod);
-
-	/// Counts a weighting function for a given modulus
-	inline int price (int mod, int sizeWeight = 1, int collisionWeight = 4){
-		int collisions = countCollisions (mod);
-		return sizeWeight * mHashes.size() + collisionWeight * collisions;
-	}
+	/// Tries to calculate a perfect hash with given number of slots
+	bool calcPerfectHash (int slotCount, PerfectHash * out) const;
 
-	typedef std::pair<KeyValue, sf::HashValue> HashPair;		///< One KeyValue with the hash of the key
-	typedef std::vector<HashPair> StringHashes;					///< Maps all strings to hashes
-	StringHashes mHashes;
+	typedef std::vector<KeyValue> KeyValues;
+	KeyValues mKeys;
 };
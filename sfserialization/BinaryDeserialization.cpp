@@ -0,0 +1,324 @@
+#include "BinaryDeserialization.h"
+
+namespace sf {
+namespace binary {
+
+/// Reads a varint, returns false if the data ends before
+static bool readVarint (const char * data, int maxLength, uint64_t * value, int * length) {
+	uint64_t result = 0;
+	int shift = 0;
+	for (int i = 0; i < maxLength && shift < 64; i++) {
+		unsigned char c = (unsigned char) data[i];
+		result |= ((uint64_t) (c & 0x7f)) << shift;
+		if (!(c & 0x80)) {
+			*value  = result;
+			*length = i + 1;
+			return true;
+		}
+		shift += 7;
+	}
+	return false;
+}
+
+/// Reads a little endian fixed size integer
+static uint64_t readFixed (const char * data, int bytes) {
+	uint64_t result = 0;
+	for (int i = bytes - 1; i >= 0; i--) {
+		result = (result << 8) | (unsigned char) data[i];
+	}
+	return result;
+}
+
+bool Value::fetch (std::string & string) const {
+	if (mType != StringTag) return false;
+	string.assign (mPayload, mPayloadLength);
+	return true;
+}
+
+bool Value::fetch (StringView & view) const {
+	if (mType != StringTag) return false;
+	view = StringView (mPayload, mPayloadLength);
+	return true;
+}
+
+bool Value::fetchJson (std::string & json) const {
+	if (mType != JsonTag) return false;
+	json.assign (mPayload, mPayloadLength);
+	return true;
+}
+
+bool Value::fetch (int64_t & data) const {
+	if (mType == IntTag) {
+		data = iData;
+		return true;
+	}
+	if (mType == UIntTag) {
+		data = (int64_t) uData;
+		return true;
+	}
+	return false;
+}
+
+bool Value::fetch (double & data) const {
+	if (mType == DoubleTag || mType == FloatTag) {
+		data = fData;
+		return true;
+	}
+	return false;
+}
+
+bool Value::fetch (bool & data) const {
+	if (mType == TrueTag)  { data = true;  return true; }
+	if (mType == FalseTag) { data = false; return true; }
+	return false;
+}
+
+bool Value::fetch (Object & object) const {
+	if (mType != ObjectTag) return false;
+	object.parse (mPayload, mPayloadLength);
+	return !object.error();
+}
+
+bool Value::fetch (Array & array) const {
+	if (mType != ArrayTag) return false;
+	array.parse (mPayload, mPayloadLength);
+	return !array.error();
+}
+
+bool Value::numFetch (int64_t & data) const {
+	if (fetch (data)) return true;
+	if (mType == DoubleTag || mType == FloatTag) {
+		data = (int64_t) fData;
+		return true;
+	}
+	return false;
+}
+
+bool Value::numFetch (double & data) const {
+	if (fetch (data)) return true;
+	if (mType == IntTag) {
+		data = (double) iData;
+		return true;
+	}
+	if (mType == UIntTag) {
+		data = (double) uData;
+		return true;
+	}
+	return false;
+}
+
+bool Value::parse (const char * data, int maxLength) {
+	mType = InvalidTag;
+	if (maxLength <= 0) return false;
+	mData = data;
+	Tag tag = (Tag) (unsigned char) data[0];
+	const char * p = data + 1;
+	int left = maxLength - 1;
+	switch (tag) {
+		case NullTag:
+		case FalseTag:
+		case TrueTag:
+			mLength = 1;
+			break;
+		case IntTag:
+		case UIntTag:{
+			uint64_t v;
+			int l;
+			if (!readVarint (p, left, &v, &l)) return false;
+			if (tag == IntTag) iData = (int64_t) (v >> 1) ^ -(int64_t) (v & 1); // zigzag
+			else uData = v;
+			mLength = 1 + l;
+		}
+		break;
+		case FloatTag: {
+			if (left < 4) return false;
+			uint32_t bits = (uint32_t) readFixed (p, 4);
+			float f;
+			memcpy (&f, &bits, sizeof (f));
+			fData = f;
+			mLength = 5;
+		}
+		break;
+		case DoubleTag: {
+			if (left < 8) return false;
+			uint64_t bits = readFixed (p, 8);
+			memcpy (&fData, &bits, sizeof (fData));
+			mLength = 9;
+		}
+		break;
+		case StringTag:
+		case JsonTag: {
+			uint64_t v;
+			int l;
+			if (!readVarint (p, left, &v, &l)) return false;
+			if (v > (uint64_t) (left - l)) return false;
+			mPayload       = p + l;
+			mPayloadLength = (int) v;
+			mLength        = 1 + l + mPayloadLength;
+		}
+		break;
+		case ArrayTag:
+		case ObjectTag: {
+			if (left < 4) return false;
+			uint64_t v = readFixed (p, 4);
+			if (v > (uint64_t) (left - 4)) return false;
+			mPayload       = p + 4;
+			mPayloadLength = (int) v;
+			mLength        = 5 + mPayloadLength;
+		}
+		break;
+		default:
+			return false;
+	}
+	mType = tag;
+	return true;
+}
+
+const Value & Array::get (int id) const {
+	static Value invalid;
+	if (id >= 0 && id < (int) mValues.size()) return mValues[id];
+	return invalid;
+}
+
+void Array::parse (const char * data, int length) {
+	mValues.clear ();
+	mError = false;
+	int i = 0;
+	while (i < length) {
+		Value v;
+		if (!v.parse (data + i, length - i)) {
+			mValues.clear ();
+			mError = true;
+			return;
+		}
+		i += v.length();
+		mValues.push_back (v);
+	}
+}
+
+const Value & Object::get (int id, const char * name) const {
+	if (id >= 0 && id < (int) mFieldTable.size()) {
+		int position = mFieldTable[id];
+		if (position >= 0) return mEntries[position].mValue;
+	} else if (id >= 0 && mFieldTable.empty()) {
+		// no lookup table for sparse ids
+		for (std::vector<Entry>::const_iterator i = mEntries.begin(); i != mEntries.end(); i++){
+			if (i->mId == id) return i->mValue;
+		}
+	}
+	return get (name);
+}
+
+const Value & Object::getBase (int index) const {
+	static Value invalidValue;
+	for (std::vector<Entry>::const_iterator i = mEntries.begin(); i != mEntries.end(); i++){
+		if (i->mBase == index) return i->mValue;
+	}
+	return invalidValue;
+}
+
+const Value & Object::get (const char * name) const {
+	static Value invalidValue;
+	int l = (int) strlen (name);
+	for (std::vector<Entry>::const_iterator i = mEntries.begin(); i != mEntries.end(); i++){
+		if (i->mNameLength != l || i->mId >= 0 || i->mBase >= 0) continue;
+		if (memcmp (i->mName, name, l) == 0) return i->mValue;
+	}
+	return invalidValue;
+}
+
+void Object::parse (const char * data, int length) {
+	mEntries.clear ();
+	mFieldTable.clear ();
+	mError = false;
+	int i = 0;
+	int maxId = -1;
+	while (i < length) {
+		Entry e;
+		uint64_t header;
+		int l;
+		if (!readVarint (data + i, length - i, &header, &l)) goto ErrorCase;
+		i += l;
+		if ((header & 1) == 0) {
+			// named key
+			uint64_t nameLength = header >> 1;
+			if (nameLength > (uint64_t) (length - i)) goto ErrorCase;
+			e.mName       = data + i;
+			e.mNameLength = (int) nameLength;
+			i += e.mNameLength;
+		} else {
+			uint64_t id = header >> 2;
+			if (id > 0x7fffffff) goto ErrorCase;
+			if (header & 2) {
+				e.mBase = (int) id;
+			} else {
+				e.mId = (int) id;
+				if (e.mId > maxId) maxId = e.mId;
+			}
+		}
+		if (!e.mValue.parse (data + i, length - i)) goto ErrorCase;
+		i += e.mValue.length();
+		mEntries.push_back (e);
+	}
+	// Lookup table for field ids, only for dense ids (they are usually assigned in declaration order)
+	if (maxId >= 0 && maxId < 4 * (int) mEntries.size() + 16) {
+		mFieldTable.resize (maxId + 1, -1);
+		for (size_t j = 0; j < mEntries.size(); j++) {
+			if (mEntries[j].mId >= 0) mFieldTable[mEntries[j].mId] = (int) j;
+		}
+	}
+	return;
+
+	ErrorCase:
+	mEntries.clear ();
+	mError = true;
+}
+
+Value parse (const char * data, int length) {
+	Value v;
+	v.parse (data, length);
+	return v;
+}
+
+}
+
+bool deserialize (const binary::Value & v, InternedString & s) {
+	StringView raw;
+	if (!v.fetch (raw)) return false;
+	StringPool * pool = DeserializationContext::current().pool;
+	s = pool ? pool->intern (raw.data(), raw.size()) : InternedString (raw.str());
+	return true;
+}
+
+BinaryDeserialization::BinaryDeserialization () : mShared (0) {
+}
+
+BinaryDeserialization::BinaryDeserialization (const std::string & s) : mShared (0) {
+	mText = s;
+	init (mText.c_str(), mText.length());
+}
+
+BinaryDeserialization::BinaryDeserialization (const ByteArrayBase & array) : mShared (0) {
+	if (array.empty()) return; // stays in error state
+	init (&array.front(), array.size());
+}
+
+BinaryDeserialization::BinaryDeserialization (const binary::Object & o) : mShared (0) {
+	mObject = o;
+}
+
+BinaryDeserialization::BinaryDeserialization (const BinaryDeserialization & derived, int baseIndex) : mShared (0) {
+	const binary::Value & v = derived.object().getBase (baseIndex);
+	if (v.valid()) {
+		v.fetch (mObject);
+	} else {
+		mShared = &derived.object();
+	}
+}
+
+void BinaryDeserialization::init (const char * data, int length) {
+	binary::Value v = binary::parse (data, length);
+	v.fetch (mObject);
+}
+
+}
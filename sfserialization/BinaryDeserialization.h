@@ -0,0 +1,453 @@
+#pragma once
+#include "types.h"
+#include "BinarySerialization.h"
+#include "Deserialization.h"
+#include <boost/utility/enable_if.hpp>
+#include <boost/type_traits/is_enum.hpp>
+#include <boost/lexical_cast.hpp>
+
+namespace sf {
+class BinaryDeserialization;
+
+namespace binary {
+
+///@cond DEV
+
+class Object;
+class Array;
+
+/// A value inside binary data. Like json::Value it does not copy the data.
+class Value {
+public:
+	Value () : mData (0), mLength (0), mPayload (0), mPayloadLength (0), mType (InvalidTag) {}
+
+	/// Fetches a string
+	/// @return whether type was Ok
+	bool fetch (std::string & string) const;
+
+	/// Fetches a string without copying it
+	/// @return whether type was Ok
+	bool fetch (StringView & view) const;
+
+	/// Fetches embedded JSON code (JsonTag)
+	/// @return whether type was Ok
+	bool fetchJson (std::string & json) const;
+
+	/// Fetches an int64 type.
+	/// @return whether type was Ok
+	bool fetch (int64_t & data) const;
+
+	/// Fetches a double type (also accepts floats)
+	/// @return whether type was Ok
+	bool fetch (double & data) const;
+
+	/// Fetches a boolean type.
+	/// @return whether type was Ok
+	bool fetch (bool & data) const;
+
+	/// Fetches a sub object.
+	/// @return whether type was Ok and the sub object could be parsed.
+	bool fetch (Object & object) const;
+
+	/// Fetches an array
+	/// @return whether type was Ok and the array was successfully parsed
+	bool fetch (Array & array) const;
+
+	/// Fetches an numerical type (do not care about int/float)
+	/// @return whether type was Ok
+	bool numFetch (int64_t & data) const;
+
+	/// Fetches an numerical type (do not care about int/float)
+	/// @return whether type was Ok
+	bool numFetch (double & data) const;
+
+	/// Returns the type of the value, InvalidTag if it is not valid
+	Tag type () const { return mType; }
+
+	/// Value is a valid type
+	bool valid () const { return mType != InvalidTag; }
+
+	/// Parses a value; returns true on success
+	bool parse (const char * data, int maxLength);
+
+	/// Length of the value in bytes (including tag)
+	int length () const { return mLength; }
+
+private:
+	const char * mData;		///< Position where the value begins (the tag)
+	int mLength;			///< Length of the full value
+	const char * mPayload;	///< Begin of string data or of container body
+	int mPayloadLength;		///< Length of string data or of container body
+	union {
+		double fData;		///< Double data (if type == FloatTag or DoubleTag)
+		int64_t iData;		///< Integer data (if type == IntTag)
+		uint64_t uData;		///< Unsigned integer data (if type == UIntTag)
+	};
+	Tag mType;
+};
+
+/// A stored name (or field id) value pair
+class Entry {
+public:
+	Entry () : mName (0), mNameLength (0), mId (-1), mBase (-1) {}
+	/// Returns the name of the entry (empty if it has a field id)
+	std::string name () const { return std::string (mName, mName + mNameLength); }
+	/// Returns the field id of the entry (or -1 if it has a name)
+	int id () const { return mId; }
+	/// Returns the value of the entry
+	const Value & value () const { return mValue; }
+private:
+	friend class Object;
+	const char * mName;		///< Name of the key (not 0-terminated)
+	int mNameLength;		///< Length of the key
+	int mId;				///< Field id or -1
+	int mBase;				///< Base class index or -1
+	Value mValue;
+};
+
+/// A binary array
+class Array {
+public:
+	Array () : mError (true) {}
+
+	/// Returns error state
+	bool error () const { return mError; }
+
+	/// Access to the entries
+	const Value & get (int id) const;
+
+	/// How many entries are in the array
+	int count () const { return (int) mValues.size(); }
+
+	/// Parses the body of an array
+	void parse (const char * data, int length);
+private:
+	std::vector<Value> mValues;
+	bool mError;
+};
+
+/// A binary object (a list of key value pairs)
+class Object {
+public:
+	Object () : mError (true) {}
+
+	/// Returns error state
+	bool error () const { return mError; }
+
+	/// Fetches a value with the given key. Returns an invalid value if nothing found
+	const Value & get (const char * name) const;
+
+	/// Fetches a value with the given field id, or if there is none, with the given key.
+	const Value & get (int id, const char * name) const;
+
+	/// Fetches the sub object of a base class (only present if written with field ids)
+	const Value & getBase (int index) const;
+
+	/// Number of entries
+	size_t entryCount () const { return mEntries.size(); }
+
+	/// Access to the entries
+	const Entry & entry (size_t i) const { return mEntries[i]; }
+
+	/// Parses the body of an object
+	void parse (const char * data, int length);
+private:
+	std::vector<Entry> mEntries;
+	std::vector<int> mFieldTable;	///< Maps field ids to entry positions (-1 if not present)
+	bool mError;
+};
+
+/// Parses binary data and returns it in a Value
+Value parse (const char * data, int length);
+
+///@endcond DEV
+
+}
+
+#ifdef __GNUC__
+// SFINAE test whether there is a binary deserialize method
+template <typename T>
+class hasBinaryDeserialize
+{
+    typedef char one;
+    typedef long two;
+
+#ifdef __GXX_EXPERIMENTAL_CXX0X__
+    template <typename C> static one test( decltype(static_cast<C*>(0)->deserialize (*static_cast<const BinaryDeserialization*>(0))) * ) ;
+#else
+    template <typename C> static one test( typeof(static_cast<C*>(0)->deserialize (*static_cast<const BinaryDeserialization*>(0))) * ) ;
+#endif
+    template <typename C> static two test(...);
+
+public:
+    enum { value = sizeof(test<T>(0)) == sizeof(char) };
+};
+
+// forward declaration
+template <typename T>
+ typename boost::enable_if_c< !boost::is_enum<T>::value && hasBinaryDeserialize<T>::value, bool>::type deserialize (const binary::Value & v, T & obj);
+template <typename T>
+ typename boost::enable_if_c< !boost::is_enum<T>::value && !hasBinaryDeserialize<T>::value, bool>::type deserialize (const binary::Value & v, T & obj);
+#endif
+#ifdef _MSC_VER
+template <typename T>
+ typename boost::disable_if< boost::is_enum<T>, bool>::type deserialize (const binary::Value & v, T & e);
+#endif
+
+/// Reads int32 value from the item
+/// @return true on success
+inline bool deserialize (const binary::Value & v, int32_t & i){
+	int64_t x;
+	bool suc = v.numFetch (x);
+	if (suc) {
+		i = x;
+	}
+	return suc;
+}
+
+/// Reads int64 value from the item
+/// @return true on success
+inline bool deserialize (const binary::Value & v, int64_t & i){
+	return v.numFetch(i);
+}
+
+/// Reads float value from the item
+/// @return true on success
+inline bool deserialize (const binary::Value & v, float & f){
+	double x;
+	bool suc = v.numFetch(x);
+	if (suc) {
+		f = x;
+	}
+	return suc;
+}
+
+/// Reads double value from the item
+/// @return true on success
+inline bool deserialize (const binary::Value & v, double & d){
+	return v.numFetch(d);
+}
+
+/// Reads std::string value from item
+/// @return true on success
+inline bool deserialize (const binary::Value & v, std::string & s){
+	return v.fetch(s);
+}
+
+/// Reads a string without copying it, the view points into the binary data
+/// @return true on success
+inline bool deserialize (const binary::Value & v, StringView & s){
+	return v.fetch(s);
+}
+
+/// Reads a string and resolves it with the StringPool of the current DeserializationContext (if any)
+/// @return true on success
+bool deserialize (const binary::Value & v, InternedString & s);
+
+/// Reads boolean value from item
+/// @return true on success
+inline bool deserialize (const binary::Value & v, bool & b) {
+	return v.fetch(b);
+}
+
+/// Reads an enum value (with fromString method)
+template <typename T>
+ typename boost::enable_if< boost::is_enum<T>, bool>::type deserialize (const binary::Value & v, T & e){
+	StringView s;
+	if (!v.fetch(s)) return false;
+	return enumFromString (s.data(), s.size(), e);
+}
+
+/// Reads a std::set out of a binary array
+template <class T> bool deserialize (const binary::Value & v, std::set<T> & set){
+	binary::Array a;
+	if (!v.fetch(a)) return false;
+	set.clear ();
+	for (int i = 0; i < a.count(); i++){
+		T x;
+		if (!deserialize (a.get(i), x)) return false;
+		set.insert (x);
+	}
+	return true;
+}
+
+/// Reads a std::vector<bool> out of a binary array, its elements are bits and cannot be
+/// deserialized in place
+inline bool deserialize (const binary::Value & v, std::vector<bool> & vector){
+	binary::Array a;
+	if (!v.fetch(a)) return false;
+	vector.clear ();
+	vector.reserve (a.count());
+	for (int i = 0; i < a.count(); i++){
+		bool x;
+		if (!deserialize (a.get(i), x)) return false;
+		vector.push_back (x);
+	}
+	return true;
+}
+
+/// Reads a std::vector out of a binary array
+template <class T> bool deserialize (const binary::Value & v, std::vector<T> & vector){
+	binary::Array a;
+	if (!v.fetch(a)) return false;
+	if (!DeserializationContext::current().updateInPlace) vector.clear ();
+	vector.resize (a.count());
+	for (int i = 0; i < a.count(); i++){
+		if (!deserialize (a.get(i), vector[i])) {
+			vector.resize (i);
+			return false;
+		}
+	}
+	return true;
+}
+
+/// Fetches all keys into a map
+template <typename A, typename B> bool deserialize (const binary::Value & v, std::map<A, B> & dst) {
+	binary::Object o;
+	if (!v.fetch(o)) return false;
+	dst.clear ();
+	for (size_t i = 0; i < o.entryCount(); i++) {
+		const binary::Entry & e (o.entry (i));
+		B t;
+		if (!deserialize (e.value(), t)) return false;
+		A key;
+		try {
+			key = boost::lexical_cast<A>(e.name());
+		} catch (boost::bad_lexical_cast & exception) {
+			return false;
+		}
+		dst[key] = t;
+	}
+	return true;
+}
+
+// Fetches a pair
+template <class A, class B> bool deserialize (const binary::Value & v, std::pair<A,B> & dst) {
+	binary::Object o;
+	if (!v.fetch(o)) return false;
+	return deserialize (o.get("1st"), dst.first) && deserialize (o.get("2nd"), dst.second);
+}
+
+/**
+ Provides Deserialization of binary data (see BinarySerialization)
+ with the same API like class Deserialization.
+
+	@verbatim
+	MyCoolStruct s;
+	bool suc = sf::fromBinary (data, s);
+	@endverbatim
+*/
+class BinaryDeserialization {
+public:
+	BinaryDeserialization ();
+	/// Initializes with a string (containing an object); it will make a copy of it
+	BinaryDeserialization (const std::string & s);
+	/// Initializes BinaryDeserialization, does NOT make a copy
+	BinaryDeserialization (const ByteArrayBase & array);
+	/// Initializes with a ready parsed object; note it wont make a copy
+	/// so keep the data available
+	BinaryDeserialization (const binary::Object & o);
+
+	/// Gives access to the fields of a base class with given index. They are either in a
+	/// sub object (if written with field ids) or directly inside the object of derived.
+	/// Keep derived alive while using the result.
+	BinaryDeserialization (const BinaryDeserialization & derived, int baseIndex);
+
+	/// Access one key and saves it in value
+	/// If it's not found it will use the default value
+	/// @return true on success
+	template <class T> bool operator() (const char * key, T & value) const {
+		const binary::Value & v = object().get(key);
+		if (v.valid()){
+			return deserialize (v, value);
+		}
+		resetValue (value);
+		return true;
+	}
+
+	/// Access one field (by field id or key) and saves it in value
+	/// If it's not found it will use the default value
+	/// @return true on success
+	template <class T> bool operator() (int id, const char * key, T & value) const {
+		const binary::Value & v = object().get(id, key);
+		if (v.valid()){
+			return deserialize (v, value);
+		}
+		resetValue (value);
+		return true;
+	}
+
+	/// Access one key and saves it in value. If key is not found, use an default value
+	/// @return true if key is not found and default value was used or key was found and from right type.
+	template <class T> bool operator() (const char * key, T & value, const T & defaultValue) const {
+		const binary::Value & v = object().get(key);
+		if (v.valid()){
+			return deserialize (v, value);
+		}
+		value = defaultValue;
+		return true;
+	}
+
+	/// BinaryDeserialization has an error (during parsing, not during getting!)
+	bool error () const { return object().error(); }
+
+private:
+	/// Parses a value containing an object
+	void init (const char * data, int length);
+
+	/// The object the fields are read from
+	const binary::Object & object () const { return mShared ? *mShared : mObject; }
+
+	std::string    mText;
+	binary::Object mObject;
+	const binary::Object * mShared;	///< Object of a derived class, if base class fields are stored inline
+};
+
+/// Deserializes a object from binary data
+/// @return true on success
+template <class T> bool fromBinary (const std::string & data, T & dst){
+	binary::Value v = binary::parse(data.c_str(), data.length());
+	return deserialize (v, dst);
+}
+
+/// Deserializes a object from binary data
+/// @return true on success
+template <class T> bool fromBinary (const ByteArrayBase & data, T & dst){
+	if (data.empty()) return false;
+	binary::Value v = binary::parse(&data.front(), data.size());
+	return deserialize (v, dst);
+}
+
+#ifdef __GNUC__
+/// Reads a regular object value (with binary deserialize method)
+template <typename T>
+ typename boost::enable_if_c< !boost::is_enum<T>::value && hasBinaryDeserialize<T>::value, bool>::type deserialize (const binary::Value & v, T & obj){
+	binary::Object o;
+	if (!v.fetch (o)){
+		return false;
+	}
+	BinaryDeserialization d (o);
+	return obj.deserialize (d);
+}
+
+/// Objects with JSON deserialize method only are embedded as JSON code
+template <typename T>
+ typename boost::enable_if_c< !boost::is_enum<T>::value && !hasBinaryDeserialize<T>::value, bool>::type deserialize (const binary::Value & v, T & obj){
+	std::string json;
+	if (!v.fetchJson (json)){
+		return false;
+	}
+	return fromJSON (json, obj);
+}
+#endif
+
+#ifdef _MSC_VER
+template<class T> typename boost::disable_if< boost::is_enum<T>, bool>::type deserialize (const binary::Value & v, T & obj){
+	binary::Object o;
+	if (!v.fetch (o)) return false;
+	BinaryDeserialization d (o);
+	return obj.deserialize (d);
+ }
+#endif
+
+}
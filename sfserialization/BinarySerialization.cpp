@@ -0,0 +1,183 @@
+#include "BinarySerialization.h"
+
+#include <stdio.h>
+#include <assert.h>
+
+namespace sf {
+
+void BinarySerialization::sizeHint (size_t size){
+	mTarget.reserve (mTarget.size() + size);
+}
+
+void BinarySerialization::beginObject () {
+	beginContainer (binary::ObjectTag);
+}
+
+void BinarySerialization::endObject () {
+	endContainer ();
+}
+
+void BinarySerialization::beginArray () {
+	beginContainer (binary::ArrayTag);
+}
+
+void BinarySerialization::endArray () {
+	endContainer ();
+}
+
+void BinarySerialization::insertKey (const char * key) {
+	size_t length = strlen (key);
+	appendVarint ((uint64_t) length << 1);
+	mTarget.append (key, length);
+}
+
+void BinarySerialization::insertFieldId (int id) {
+	appendVarint (((uint64_t) id << 2) | 1);
+}
+
+void BinarySerialization::beginBase (int index) {
+	if (!mFieldIds) return; // fields of the base class go into the same object
+	appendVarint (((uint64_t) index << 2) | 3);
+	beginObject ();
+}
+
+void BinarySerialization::endBase () {
+	if (!mFieldIds) return;
+	endObject ();
+}
+
+void BinarySerialization::insertNull () {
+	appendTag (binary::NullTag);
+}
+
+void BinarySerialization::insertBool (bool value) {
+	appendTag (value ? binary::TrueTag : binary::FalseTag);
+}
+
+void BinarySerialization::insertInt (int64_t value) {
+	appendTag (binary::IntTag);
+	// zigzag encoding, small negative numbers get small varints
+	appendVarint (((uint64_t) value << 1) ^ (uint64_t) (value >> 63));
+}
+
+void BinarySerialization::insertUInt (uint64_t value) {
+	appendTag (binary::UIntTag);
+	appendVarint (value);
+}
+
+void BinarySerialization::insertFloat (float value) {
+	uint32_t bits;
+	memcpy (&bits, &value, sizeof (bits));
+	appendTag (binary::FloatTag);
+	appendFixed (bits, 4);
+}
+
+void BinarySerialization::insertDouble (double value) {
+	uint64_t bits;
+	memcpy (&bits, &value, sizeof (bits));
+	appendTag (binary::DoubleTag);
+	appendFixed (bits, 8);
+}
+
+void BinarySerialization::insertString (const char * data, size_t length) {
+	appendTag (binary::StringTag);
+	appendVarint (length);
+	mTarget.append (data, length);
+}
+
+void BinarySerialization::insertJson (const std::string & json) {
+	appendTag (binary::JsonTag);
+	appendVarint (json.size());
+	mTarget.append (json);
+}
+
+void BinarySerialization::appendTag (binary::Tag tag) {
+	mTarget.push_back ((char) tag);
+}
+
+void BinarySerialization::appendVarint (uint64_t value) {
+	char buf [10];
+	int i = 0;
+	while (value >= 0x80) {
+		buf[i++] = (char) ((value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+	buf[i++] = (char) value;
+	mTarget.append (buf, i);
+}
+
+void BinarySerialization::appendFixed (uint64_t value, int bytes) {
+	char buf [8];
+	for (int i = 0; i < bytes; i++) {
+		buf[i] = (char) (value & 0xff);
+		value >>= 8;
+	}
+	mTarget.append (buf, bytes);
+}
+
+void BinarySerialization::beginContainer (binary::Tag tag) {
+	appendTag (tag);
+	mOpen.push_back (mTarget.size());
+	mTarget.append (4, '\0'); // length, will be patched by endContainer
+}
+
+void BinarySerialization::endContainer () {
+	if (mOpen.empty()){
+		fprintf (stderr, "BinarySerialization::endContainer no open container");
+		assert (false && "No open container");
+		return;
+	}
+	size_t position = mOpen.back();
+	mOpen.pop_back();
+	uint32_t length = (uint32_t) (mTarget.size() - position - 4);
+	for (int i = 0; i < 4; i++) {
+		mTarget[position + i] = (char) (length & 0xff);
+		length >>= 8;
+	}
+}
+
+void serialize (BinarySerialization & s, int32_t data) {
+	s.insertInt (data);
+}
+
+void serialize (BinarySerialization & s, int64_t data) {
+	s.insertInt (data);
+}
+
+void serialize (BinarySerialization & s, uint32_t data) {
+	s.insertUInt (data);
+}
+
+void serialize (BinarySerialization & s, uint64_t data) {
+	s.insertUInt (data);
+}
+
+void serialize (BinarySerialization & s, float data) {
+	s.insertFloat (data);
+}
+
+void serialize (BinarySerialization & s, double data) {
+	s.insertDouble (data);
+}
+
+void serialize (BinarySerialization & s, bool data) {
+	s.insertBool (data);
+}
+
+void serialize (BinarySerialization & s, const std::string& data) {
+	s.insertString (data.c_str(), data.size());
+}
+
+void serialize (BinarySerialization & s, const char* data) {
+	s.insertString (data, strlen (data));
+}
+
+void serialize (BinarySerialization & s, const StringView & data) {
+	s.insertString (data.data(), data.size());
+}
+
+void serialize (BinarySerialization & s, const InternedString & data) {
+	s.insertString (data.c_str(), data.size());
+}
+
+}
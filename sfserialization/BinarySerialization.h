@@ -0,0 +1,281 @@
+#pragma once
+#include "types.h"
+#include "isdefault.h"
+#include "Serialization.h"
+#include <boost/utility/enable_if.hpp>
+#include <boost/type_traits/is_enum.hpp>
+#include <boost/lexical_cast.hpp>
+#include <string.h>
+
+/**
+ * @file
+ * A compact binary alternative to the JSON serialization.
+ *
+ * The format is self describing (in the style of MessagePack or CBOR), every value starts with
+ * a one byte binary::Tag:
+ * - integers are stored as (zigzag-) varints
+ * - floats and doubles as raw little endian IEEE 754 values
+ * - strings with a varint length prefix
+ * - arrays and objects with a 4 byte little endian length prefix (so that a reader can skip them
+ *   in constant time), object entries are stored as a varint header, the key (if any) and the value.
+ *
+ * The header of an object entry is either
+ * - (key length << 1) for named keys (the key follows),
+ * - (field id << 2) | 1 for numeric field ids (FIELD_IDS mode) or
+ * - (base index << 2) | 3 for a base class which is stored as a sub object (FIELD_IDS mode).
+ *
+ * Field ids are assigned by sfautoreflect in declaration order (starting with 1) or explicitly
+ * with SF_AUTOREFLECT_FIELDID (member, id). As ids are only unique inside one class, base classes
+ * are stored in sub objects when using field ids.
+ *
+ * Types reflected with SF_AUTOREFLECT_SD get a binary serialize/deserialize method automatically,
+ * types which only provide the JSON methods are embedded as JSON text (binary::JsonTag).
+ */
+
+namespace sf {
+class BinarySerialization;
+
+namespace binary {
+
+/// Type tag which precedes every value in the binary format
+enum Tag {
+	NullTag = 0,	///< No payload
+	FalseTag,		///< Boolean false, no payload
+	TrueTag,		///< Boolean true, no payload
+	IntTag,			///< Zigzag encoded varint
+	UIntTag,		///< Varint
+	FloatTag,		///< 4 byte IEEE 754 (little endian)
+	DoubleTag,		///< 8 byte IEEE 754 (little endian)
+	StringTag,		///< Varint length + bytes
+	ArrayTag,		///< 4 byte body length + values
+	ObjectTag,		///< 4 byte body length + entries (varint header, key, value)
+	JsonTag,		///< Varint length + JSON code (for types without binary serializer)
+	InvalidTag = 0xff	///< Not used on the wire, marks invalid values
+};
+
+}
+
+/** Serializes objects into the compact binary format.
+	It has the same API like sf::Serialization, so the same serialize methods can be used.
+
+	@verbatim
+	MyCoolStruct s;
+	std::string data = sf::toBinary (s);
+	@endverbatim
+*/
+class BinarySerialization {
+public:
+	/**
+	 * Initializes binary Serialization
+	 * @param target         where the binary data will go
+	 * @param compress       compress the output (only serialize objects, which are not default values)
+	 * @param fieldIds       write numeric field ids instead of key names (where available)
+	 */
+	BinarySerialization (std::string & target, bool compress = false, bool fieldIds = false) :
+		mTarget (target),
+		mCompress (compress),
+		mFieldIds (fieldIds) {}
+
+	/// Gives a hint how big the serialization will probably be (used for reserving data)
+	void sizeHint (size_t data);
+
+public:
+
+	///@ manual Building binary Structure
+	///@{
+
+	/// Begins an object, must be closed with endObject
+	void beginObject ();
+	/// Ends an object
+	void endObject ();
+	/// Begins an array, must be closed with endArray
+	void beginArray ();
+	/// Ends an array
+	void endArray ();
+	/// Insert a key name (only inside objects, afterwards it will wait for a value)
+	void insertKey (const char * key);
+	/// Insert a numeric field id (only inside objects, afterwards it will wait for a value)
+	void insertFieldId (int id);
+	/// Begins the fields of a base class. With field ids they go into a sub object.
+	void beginBase (int index);
+	/// Ends the fields of a base class
+	void endBase ();
+	/// Insert a null value
+	void insertNull ();
+	/// Insert a boolean value
+	void insertBool (bool value);
+	/// Insert a signed integer value
+	void insertInt (int64_t value);
+	/// Insert an unsigned integer value
+	void insertUInt (uint64_t value);
+	/// Insert a float value
+	void insertFloat (float value);
+	/// Insert a double value
+	void insertDouble (double value);
+	/// Insert a string value
+	void insertString (const char * data, size_t length);
+	/// Insert JSON code (for types which cannot be serialized binary)
+	void insertJson (const std::string & json);
+
+	///@}
+
+	/// Serializes a field with given key name and Value
+	template <class T> void operator () (const char * key, const T & value){
+		if (!mCompress || !isDefault(value)){
+			insertKey (key);
+			serialize (*this, value);
+		}
+	}
+
+	/// Serializes a field with given field id (or key name if not using field ids) and Value
+	template <class T> void operator () (int id, const char * key, const T & value){
+		if (!mCompress || !isDefault(value)){
+			if (mFieldIds) insertFieldId (id);
+			else insertKey (key);
+			serialize (*this, value);
+		}
+	}
+
+	/// Writes field ids instead of key names
+	bool fieldIds () const { return mFieldIds; }
+
+private:
+	void appendTag (binary::Tag tag);
+	void appendVarint (uint64_t value);
+	void appendFixed (uint64_t value, int bytes);
+
+	/// Opens a container with a placeholder for the length
+	void beginContainer (binary::Tag tag);
+	/// Writes the length of the innermost open container
+	void endContainer ();
+
+	std::string & mTarget;
+	bool mCompress;					///< Only serialize values which are different to isDefault()
+	bool mFieldIds;					///< Write field ids instead of key names
+	std::vector<size_t> mOpen;		///< Positions of the length fields of open containers
+};
+
+/// Converts a given object into the binary format
+template <class T> std::string toBinary (const T & obj){
+	std::string target;
+	BinarySerialization serialization (target);
+	serialize (serialization, obj); // koenig lookup
+	return target;
+}
+
+/// Converts a given object into the binary format, COMPRESS and FIELD_IDS of SerializationFlags are supported
+template <class T> std::string toBinaryEx (const T & obj, int flags){
+	std::string target;
+	BinarySerialization serialization (target, flags & COMPRESS, flags & FIELD_IDS);
+	serialize (serialization, obj); // koenig lookup
+	return target;
+}
+
+// Serializer for plain types
+
+void serialize (BinarySerialization & s, int32_t data);
+void serialize (BinarySerialization & s, int64_t data);
+void serialize (BinarySerialization & s, uint32_t data);
+void serialize (BinarySerialization & s, uint64_t data);
+void serialize (BinarySerialization & s, float data);
+void serialize (BinarySerialization & s, double data);
+void serialize (BinarySerialization & s, bool data);
+void serialize (BinarySerialization & s, const std::string& data);
+void serialize (BinarySerialization & s, const char* data);
+void serialize (BinarySerialization & s, const StringView & data);
+void serialize (BinarySerialization & s, const InternedString & data);
+
+/// Serialize method for sets
+template <class T> static void serialize (sf::BinarySerialization & s, const std::set<T> & container) {
+	s.beginArray ();
+	for (typename std::set<T>::const_iterator i = container.begin(); i != container.end(); i++){
+		serialize (s, *i);
+	}
+	s.endArray ();
+}
+
+/// Serialize methods for vectors
+template <class T> static void serialize (sf::BinarySerialization &s, const std::vector<T> & container) {
+	s.beginArray ();
+	for (typename std::vector<T>::const_iterator i = container.begin(); i != container.end(); i++){
+		serialize (s, *i);
+	}
+	s.endArray ();
+}
+
+/// Serialize method for maps
+template <typename A, typename B> void serialize (BinarySerialization & s, const std::map<A, B> & data) {
+	s.beginObject ();
+	for (typename std::map<A, B>::const_iterator i = data.begin(); i != data.end(); i++) {
+		s.insertKey (boost::lexical_cast<std::string>(i->first).c_str());
+		serialize (s, i->second);
+	}
+	s.endObject ();
+}
+
+/// Serialize method for a pair
+template <typename A, typename B> void serialize (BinarySerialization & s, const std::pair<A,B> & obj){
+	s.beginObject ();
+	s.insertKey ("1st");
+	serialize (s, obj.first);
+	s.insertKey ("2nd");
+	serialize (s, obj.second);
+	s.endObject ();
+}
+
+/// Serialize an enum
+template <typename T>
+ typename boost::enable_if< boost::is_enum<T>, void>::type
+ serialize (BinarySerialization & s, const T & t){
+	const char * str = toString (t);
+	s.insertString (str, strlen (str));
+}
+
+#ifdef __GNUC__
+// SFINAE test whether there is a binary serialize method
+template <typename T>
+class hasBinarySerialize
+{
+    typedef char one;
+    typedef long two;
+
+#ifdef __GXX_EXPERIMENTAL_CXX0X__
+    template <typename C> static one test( decltype(static_cast<const C*>(0)->serialize (*static_cast<BinarySerialization*>(0))) * ) ;
+#else
+    template <typename C> static one test( typeof(static_cast<const C*>(0)->serialize (*static_cast<BinarySerialization*>(0))) * ) ;
+#endif
+    template <typename C> static two test(...);
+
+public:
+    enum { value = sizeof(test<T>(0)) == sizeof(char) };
+};
+
+/// General serialize function for objects with binary serialize method
+template <typename T>
+ typename boost::enable_if_c< !boost::is_enum<T>::value && hasBinarySerialize<T>::value, void>::type
+ serialize (BinarySerialization & s, const T & obj){
+	s.beginObject ();
+	obj.serialize (s);
+	s.endObject ();
+}
+
+/// Objects with JSON serialize method only are embedded as JSON code
+template <typename T>
+ typename boost::enable_if_c< !boost::is_enum<T>::value && !hasBinarySerialize<T>::value, void>::type
+ serialize (BinarySerialization & s, const T & obj){
+	s.insertJson (toJSON (obj));
+}
+#endif
+
+#ifdef _MSC_VER
+/// General serialize function for objects
+template <typename T>
+ typename boost::disable_if< boost::is_enum<T>, void>::type
+ serialize (BinarySerialization & s, const T & obj){
+	s.beginObject ();
+	obj.serialize (s);
+	s.endObject ();
+}
+#endif
+
+}
@@ -2,33 +2,52 @@
 
 namespace sf {
 
-Deserialization::Deserialization () {
+Deserialization::Deserialization () : mMask (0) {
 }
 
-Deserialization::Deserialization (const std::string & s){
+Deserialization::Deserialization (const std::string & s) : mMask (0) {
 	mText = s;
 	/// With command compatibility
 	std::string cmd;
 	mObject.init (mText.c_str(), cmd);
 }
 
-Deserialization::Deserialization (const std::string & s, std::string & cmd){
+Deserialization::Deserialization (const std::string & s, std::string & cmd) : mMask (0) {
 	mText = s;
 	mObject.init (mText.c_str(), cmd);
 }
 
-Deserialization::Deserialization (const ByteArrayBase & array) {
+Deserialization::Deserialization (const ByteArrayBase & array) : mMask (0) {
 	mObject.init (&array.front(), array.size());
 }
 
-Deserialization::Deserialization (const ByteArrayBase & array, std::string & cmd) {
+Deserialization::Deserialization (const ByteArrayBase & array, std::string & cmd) : mMask (0) {
 	mObject.init (&array.front(), cmd, array.size());
 }
 
-Deserialization::Deserialization (const json::Object & o){
+Deserialization::Deserialization (const json::Object & o) : mMask (0) {
 	mObject = o;
 }
 
+Deserialization::Deserialization (const json::Object & o, const FieldMask * mask) : mMask (mask) {
+	mObject = o;
+}
+
+bool deserialize (const json::Value & v, InternedString & s) {
+	StringPool * pool = DeserializationContext::current().pool;
+	StringView raw;
+	if (pool && !v.hasEscapes()) {
+		// no decoding necessary, no temporary copy
+		if (!v.fetch (raw)) return false;
+		s = pool->intern (raw.data(), raw.size());
+		return true;
+	}
+	std::string decoded;
+	if (!v.fetch (decoded, true)) return false;
+	s = pool ? pool->intern (decoded) : InternedString (decoded);
+	return true;
+}
+
 void Deserialization::streamOut (std::ostream & stream) const {
 	stream << mObject;
 }
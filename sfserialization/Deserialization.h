@@ -1,6 +1,10 @@
 #pragma once
 #include "types.h"
 #include "JSONParser.h"
+#include "MappedFile.h"
+#include "StringPool.h"
+#include "DeserializationContext.h"
+#include <limits.h>
 #include <boost/utility/enable_if.hpp>
 #include <boost/type_traits/is_enum.hpp>
 #include <boost/lexical_cast.hpp>
@@ -16,10 +20,11 @@ class hasDeserialize
     typedef char one;
     typedef long two;
 
+    // Checks for the exact signature, deserialize may be overloaded (e.g. for BinaryDeserialization)
 #ifdef __GXX_EXPERIMENTAL_CXX0X__
-    template <typename C> static one test( decltype(&C::deserialize) ) ;
+    template <typename C> static one test( decltype(static_cast<C*>(0)->deserialize (*static_cast<const Deserialization*>(0))) * ) ;
 #else
-    template <typename C> static one test( typeof(&C::deserialize) ) ;
+    template <typename C> static one test( typeof(static_cast<C*>(0)->deserialize (*static_cast<const Deserialization*>(0))) * ) ;
 #endif
     template <typename C> static two test(...);
 
@@ -77,70 +82,190 @@ inline bool deserialize (const json::Value & v, std::string & s){
 	return v.fetch(s, true);
 }
 
+/// Reads a string without copying it, the view points into the JSON code.
+/// Fails for strings with escape sequences, as they would need decoding.
+/// @return true on success
+inline bool deserialize (const json::Value & v, StringView & s){
+	if (v.hasEscapes()) return false;
+	return v.fetch(s);
+}
+
+/// Reads a string and resolves it with the StringPool of the current DeserializationContext (if any)
+/// @return true on success
+bool deserialize (const json::Value & v, InternedString & s);
+
 /// Reads boolean value from item
 /// @return true on success
 inline bool deserialize (const json::Value & v, bool & b) {
 	return v.fetch(b);
 }
 
+#ifdef __GNUC__
+// SFINAE test whether there is a length aware fromString function (generated by sfautoreflect)
+template <typename T>
+class hasLengthFromString
+{
+    typedef char one;
+    typedef long two;
+
+#ifdef __GXX_EXPERIMENTAL_CXX0X__
+    template <typename C> static one test( decltype(fromString (static_cast<const char*>(0), size_t(0), *static_cast<C*>(0))) * ) ;
+#else
+    template <typename C> static one test( typeof(fromString (static_cast<const char*>(0), size_t(0), *static_cast<C*>(0))) * ) ;
+#endif
+    template <typename C> static two test(...);
+
+public:
+    enum { value = sizeof(test<T>(0)) == sizeof(char) };
+};
+
+/// Converts a (not 0-terminated) string into an enum, without copying
+template <typename T>
+ typename boost::enable_if_c< hasLengthFromString<T>::value, bool>::type enumFromString (const char * s, size_t length, T & e){
+	return fromString (s, length, e);
+}
+
+/// Converts a (not 0-terminated) string into an enum which only has fromString (const char*, T&)
+template <typename T>
+ typename boost::disable_if_c< hasLengthFromString<T>::value, bool>::type enumFromString (const char * s, size_t length, T & e){
+	std::string copy (s, length);
+	return fromString (copy.c_str(), e);
+}
+#endif
+
+#ifdef _MSC_VER
+/// Converts a (not 0-terminated) string into an enum
+template <typename T> bool enumFromString (const char * s, size_t length, T & e){
+	std::string copy (s, length);
+	return fromString (copy.c_str(), e);
+}
+#endif
+
 /// Reads an enum value (with fromString method)
 template <typename T>
  typename boost::enable_if< boost::is_enum<T>, bool>::type deserialize (const json::Value & v, T & e){
+	if (!v.hasEscapes()) {
+		StringView s;
+		if (!v.fetch(s)) return false;
+		return enumFromString (s.data(), s.size(), e);
+	}
 	std::string s;
-	bool suc = v.fetch(s);
-	if (!suc) return false;
-	return fromString (s.c_str(), e);
+	if (!v.fetch(s, true)) return false;
+	return enumFromString (s.c_str(), s.size(), e);
 }
 
-/// Reads a std::set out of a json Array
+/// Reads a std::set out of a json Array (left untouched if the array is malformed).
+/// On an error the set contains the elements before the failing one.
 template <class T> bool deserialize (const json::Value & v, std::set<T> & set){
-	json::Array a;
-	if (!v.fetch(a)) return false;
-	set.clear ();
-	for (int i = 0; i < a.count(); i++){
+	json::ArrayRange elements (v);
+	if (elements.error()) return false;
+	std::set<T> result;
+	for (json::ArrayIterator i = elements.begin(); i != elements.end(); ++i){
 		T x;
-		json::Value sub = a.get(i);
-		if (!deserialize (sub, x)) return false;
-		set.insert (x);
+		if (!deserialize (*i, x)) {
+			set.swap (result);
+			return false;
+		}
+		result.insert (x);
+	}
+	if (elements.error()) return false;
+	set.swap (result);
+	return true;
+}
+
+/// Reads a std::vector<bool> out of a json Array, its elements are bits and cannot be
+/// deserialized in place (otherwise like the generic vector deserializer)
+inline bool deserialize (const json::Value & v, std::vector<bool> & vector){
+	json::ArrayRange elements (v);
+	if (elements.error()) return false;
+	std::vector<bool> result;
+	for (json::ArrayIterator i = elements.begin(); i != elements.end(); ++i){
+		bool x;
+		if (!deserialize (*i, x)) {
+			vector.swap (result);
+			return false;
+		}
+		result.push_back (x);
 	}
+	if (elements.error()) return false;
+	vector.swap (result);
 	return true;
 }
 
-/// Reads a std::vector out of a json Array
+/// Reads a std::vector out of a json Array (left untouched if the array is malformed).
+/// The elements are deserialized in place. On an error the vector contains the elements before the failing one.
+/// In update mode (see DeserializationContext::updateInPlace) existing elements are reused, there
+/// a malformed array is handled like a failing element (the array is not scanned twice).
 template <class T> bool deserialize (const json::Value & v, std::vector<T> & vector){
-	json::Array a;
-	if (!v.fetch(a)) return false;
-	vector.clear ();
-	for (int i = 0; i < a.count(); i++){
-		T x;
-		json::Value sub = a.get(i);
-		if (!deserialize (sub, x)) return false;
-		vector.push_back (x);
+	json::ArrayRange elements (v);
+	if (elements.error()) return false;
+	if (DeserializationContext::current().updateInPlace) {
+		size_t n = 0;
+		for (json::ArrayIterator i = elements.begin(); i != elements.end(); ++i, ++n){
+			if (n == vector.size()) vector.push_back (T());
+			if (!deserialize (*i, vector[n])) {
+				vector.resize (n);
+				return false;
+			}
+		}
+		vector.resize (n);
+		return !elements.error();
 	}
+	std::vector<T> result;
+	for (json::ArrayIterator i = elements.begin(); i != elements.end(); ++i){
+		result.push_back (T());
+		if (!deserialize (*i, result.back())) {
+			result.pop_back ();
+			vector.swap (result);
+			return false;
+		}
+	}
+	if (elements.error()) return false;
+	vector.swap (result);
 	return true;
 }
 
-/// Fetches all keys into a map
+/// Fetches all keys into a map (left untouched if the object is malformed).
+/// On an error the map contains the entries before the failing one.
 template <typename A, typename B> bool deserialize (const json::Value & v, std::map<A, B> & dst) {
-	json::Object o;
-	if (!v.fetch(o)) return false;
-	dst.clear ();
-	const json::Entry * e = o.first ();
-	while (e) {
+	json::ObjectRange entries (v);
+	if (entries.error()) return false;
+	std::map<A, B> result;
+	for (json::ObjectIterator e = entries.begin(); e != entries.end(); ++e) {
 		B t;
-		if (!deserialize (e->value(), t)) return false;
 		A key;
+		bool suc = deserialize (e->value(), t);
 		try {
-			key = boost::lexical_cast<A>(e->name());
+			if (suc) key = boost::lexical_cast<A>(e->name());
 		} catch (boost::bad_lexical_cast & exception) {
+			suc = false;
+		}
+		if (!suc) {
+			dst.swap (result);
 			return false;
 		}
-		dst[key] = t;
-		e = e->next ();
+		result[key] = t;
 	}
+	if (entries.error()) return false;
+	dst.swap (result);
 	return true;
 }
 
+/// Sets a value to its default (used for missing keys)
+template <class T> void resetValue (T & value) {
+	value = T();
+}
+
+/// Clears a string, keeping its storage
+inline void resetValue (std::string & value) {
+	value.clear ();
+}
+
+/// Clears a vector, keeping its storage
+template <class T> void resetValue (std::vector<T> & value) {
+	value.clear ();
+}
+
 // Fetches a pair
 template <class A, class B> bool deserialize (const json::Value & v, std::pair<A,B> & dst) {
 	json::Object o;
@@ -198,23 +323,39 @@ public:
 	/// so keep the data available
 	Deserialization (const sf::json::Object& o);
 
+	/// Initializes with a ready parsed json-Object, keys not selected by the mask will be skipped
+	/// (and the values left untouched). Keep the object and the mask available.
+	Deserialization (const sf::json::Object& o, const FieldMask * mask);
+
 	/// Access one key and saves it in value
 	/// If it's not found it will use the default value
 	/// @return true on success
 	template <class T> bool operator() (const char * key, T & value) const {
-		json::Value v = mObject.get(key);
+		return operator() (json::Key (key), value);
+	}
+
+	/// Access one key (with precalculated length and hash, see json::Key) and saves it in value
+	/// If it's not found it will use the default value
+	/// @return true on success
+	template <class T> bool operator() (const json::Key & key, T & value) const {
+		if (mMask && !mMask->contains (key.name, key.length)) return true;
+		const json::Value & v = mObject.get(key);
 		if (v.valid()){
+			if (mMask) return deserialize (v, value, mMask->sub (key.name));
 			return deserialize (v, value);
 		}
-		value = T();
+		resetValue (value);
 		return true;
 	}
 
 	/// Access one key and saves it in value. If key is not found, use an default value
 	/// @return true if key is not found and default value was used or key was found and from right type.
 	template <class T> bool operator() (const char * key, T & value, const T & defaultValue) const {
-		json::Value v = mObject.get(key);
+		json::Key k (key);
+		if (mMask && !mMask->contains (k.name, k.length)) return true;
+		const json::Value & v = mObject.get(k);
 		if (v.valid()){
+			if (mMask) return deserialize (v, value, mMask->sub (key));
 			return deserialize (v, value);
 		}
 		value = defaultValue;
@@ -230,11 +371,14 @@ public:
 	/// Fetches all keys into a map
 	template <class T> bool allFetch (std::map<std::string, T> & dst) const {
 		dst.clear ();
+		std::string key; // reused for all entries
 		const json::Entry * e = mObject.first ();
 		while (e) {
 			T t;
 			if (!deserialize (e->value(), t)) return false;
-			dst[e->name()] = t;
+			StringView name = e->nameView();
+			key.assign (name.data(), name.size());
+			dst[key] = t;
 			e = e->next();
 		}
 		return true;
@@ -248,6 +392,7 @@ public:
 private:
 	std::string  mText;
 	json::Object mObject;
+	const FieldMask * mMask;	///< Only deserialize selected keys (if set)
 };
 
 /// Deserializes a object from JSON code
@@ -264,6 +409,54 @@ template <class T> bool fromJSON (const ByteArrayBase & data, T & dst){
 	return deserialize (v, dst);
 }
 
+/// Deserializes only the members selected by mask from JSON code.
+/// Other members are skipped by the parser and left untouched in dst.
+/// @return true on success
+template <class T> bool fromJSON (const std::string & txt, T & dst, const FieldMask & mask){
+	json::Value v = json::parse(txt.c_str(), txt.length());
+	return deserialize (v, dst, &mask);
+}
+
+/// Deserializes a object from JSON code, all InternedString values are resolved by pool
+/// (so that equal strings share their memory)
+/// @return true on success
+template <class T> bool fromJSON (const std::string & txt, T & dst, StringPool & pool){
+	DeserializationScope scope (&pool);
+	return fromJSON (txt, dst);
+}
+
+/// Deserializes a object from JSON code into an existing object, reusing its storage: existing
+/// elements of vectors are deserialized into and strings and vectors keep their capacity.
+/// Decoding messages with the same shape again and again does not allocate memory.
+/// @return true on success
+template <class T> bool updateFromJSON (const std::string & txt, T & dst){
+	DeserializationScope scope (DeserializationContext::current().pool, true);
+	return fromJSON (txt, dst);
+}
+
+/// Updates only the members selected by mask from JSON code, see updateFromJSON
+/// @return true on success
+template <class T> bool updateFromJSON (const std::string & txt, T & dst, const FieldMask & mask){
+	DeserializationScope scope (DeserializationContext::current().pool, true);
+	return fromJSON (txt, dst, mask);
+}
+
+/// Deserializes a object from a JSON file. The file is memory mapped and parsed in place
+/// (without copying it into a string first), so it is well suited for big files.
+/// @return true on success (false if the file could not be opened or parsed)
+template <class T> bool fromJSONFile (const char * path, T & dst){
+	MappedFile file;
+	if (!file.open (path)) return false;
+	if (file.size() > (size_t) INT_MAX) return false; // parser works with int positions
+	json::Value v = json::parse (file.data(), (int) file.size());
+	return deserialize (v, dst);
+}
+
+/// Deserializes a object from a JSON file, see above
+template <class T> bool fromJSONFile (const std::string & path, T & dst){
+	return fromJSONFile (path.c_str(), dst);
+}
+
 #ifdef __GNUC__
 /// Reads a regualar object value (with deserialize method)
 template <typename T>
@@ -290,6 +483,68 @@ template<class T> typename boost::disable_if< boost::is_enum<T>, bool>::type des
  }
 #endif
 
+#ifdef __GNUC__
+/// Reads an object, only selected members (mask == 0 means all)
+template <typename T>
+ typename boost::enable_if_c< hasDeserialize<T>::value, bool>::type deserialize (const json::Value & v, T & obj, const FieldMask * mask){
+	if (!mask) return deserialize (v, obj);
+	json::Object o;
+	if (!v.fetch (o, mask)){
+		return false;
+	}
+	Deserialization d (o, mask);
+	if (d.error()){
+		return false;
+	}
+	return obj.deserialize (d);
+}
+
+/// Reads a vector, the mask is applied to its elements (decoded in place like the unmasked vector,
+/// in update mode existing elements keep their members which are not selected by the mask)
+template <class T> bool deserialize (const json::Value & v, std::vector<T> & vector, const FieldMask * mask){
+	if (!mask) return deserialize (v, vector);
+	json::ArrayRange elements (v);
+	if (elements.error()) return false;
+	if (DeserializationContext::current().updateInPlace) {
+		size_t n = 0;
+		for (json::ArrayIterator i = elements.begin(); i != elements.end(); ++i, ++n){
+			if (n == vector.size()) vector.push_back (T());
+			if (!deserialize (*i, vector[n], mask)) {
+				vector.resize (n);
+				return false;
+			}
+		}
+		vector.resize (n);
+		return !elements.error();
+	}
+	std::vector<T> result;
+	for (json::ArrayIterator i = elements.begin(); i != elements.end(); ++i){
+		result.push_back (T());
+		if (!deserialize (*i, result.back(), mask)) {
+			result.pop_back ();
+			vector.swap (result);
+			return false;
+		}
+	}
+	if (elements.error()) return false;
+	vector.swap (result);
+	return true;
+}
+
+/// Other values do not support masks
+template <typename T>
+ typename boost::enable_if_c< !hasDeserialize<T>::value, bool>::type deserialize (const json::Value & v, T & obj, const FieldMask * mask){
+	return deserialize (v, obj);
+}
+#endif
+
+#ifdef _MSC_VER
+/// Masks are not supported, all members are read
+template <typename T> bool deserialize (const json::Value & v, T & obj, const FieldMask * mask){
+	return deserialize (v, obj);
+}
+#endif
+
 }
 
 /// Outstream operator
@@ -0,0 +1,16 @@
+#include "DeserializationContext.h"
+
+#ifdef _MSC_VER
+#define SF_THREAD_LOCAL __declspec(thread)
+#else
+#define SF_THREAD_LOCAL __thread
+#endif
+
+namespace sf {
+
+DeserializationContext & DeserializationContext::current () {
+	static SF_THREAD_LOCAL DeserializationContext context;
+	return context;
+}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+namespace sf {
+class StringPool;
+
+/**
+ * Settings of the current thread for the deserialize functions, which cannot be passed through
+ * their signature (deserialize (const json::Value&, T&) has to stay the same for all types).
+ *
+ * Set them with a DeserializationScope.
+ */
+struct DeserializationContext {
+	// POD, so that it can be stored thread local (all zero in new threads)
+	StringPool * pool;	///< Resolves InternedString values (0 = no pooling)
+	bool updateInPlace;	///< Deserialize into existing vector elements instead of replacing them
+
+	/// Returns the context of the current thread
+	static DeserializationContext & current ();
+};
+
+/**
+ * Activates settings in the DeserializationContext of the current thread,
+ * the previous ones are restored on destruction.
+ *
+ * @verbatim
+	sf::StringPool pool;
+	{
+		sf::DeserializationScope scope (&pool);
+		sf::fromJSON (json, dst);
+	}
+ * @endverbatim
+ */
+class DeserializationScope {
+public:
+	explicit DeserializationScope (StringPool * pool) : mSaved (DeserializationContext::current()) {
+		DeserializationContext::current().pool = pool;
+	}
+	DeserializationScope (StringPool * pool, bool updateInPlace) : mSaved (DeserializationContext::current()) {
+		DeserializationContext::current().pool = pool;
+		DeserializationContext::current().updateInPlace = updateInPlace;
+	}
+	~DeserializationScope () {
+		DeserializationContext::current() = mSaved;
+	}
+private:
+	// not copyable
+	DeserializationScope (const DeserializationScope &);
+	DeserializationScope & operator= (const DeserializationScope &);
+
+	DeserializationContext mSaved;
+};
+
+}
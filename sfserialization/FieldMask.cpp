@@ -0,0 +1,47 @@
+#include "FieldMask.h"
+#include <string.h>
+
+namespace sf {
+
+FieldMask::FieldMask (const char * paths) : mAll (false) {
+	const char * begin = paths;
+	for (;;) {
+		const char * end = strchr (begin, ',');
+		std::string path = end ? std::string (begin, end) : std::string (begin);
+		// trim spaces
+		size_t first = path.find_first_not_of (' ');
+		size_t last  = path.find_last_not_of (' ');
+		if (first != path.npos) add (path.substr (first, last - first + 1));
+		if (!end) break;
+		begin = end + 1;
+	}
+}
+
+void FieldMask::add (const std::string & path) {
+	size_t dot = path.find ('.');
+	if (dot == path.npos) {
+		mChildren[path].mAll = true;
+		return;
+	}
+	mChildren[path.substr (0, dot)].add (path.substr (dot + 1));
+}
+
+bool FieldMask::contains (const char * name, int length) const {
+	// masks are small, linear search without creating a string
+	for (MaskMap::const_iterator i = mChildren.begin(); i != mChildren.end(); i++) {
+		if ((int) i->first.length() == length && memcmp (i->first.c_str(), name, length) == 0) return true;
+	}
+	return false;
+}
+
+bool FieldMask::contains (const char * name) const {
+	return contains (name, (int) strlen (name));
+}
+
+const FieldMask * FieldMask::sub (const char * name) const {
+	MaskMap::const_iterator i = mChildren.find (name);
+	if (i == mChildren.end() || i->second.mAll) return 0;
+	return &i->second;
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <map>
+#include <string>
+
+namespace sf {
+
+/**
+ * A set of member paths which shall be deserialized, all other members are skipped
+ * by the parser (and left untouched in the destination object).
+ *
+ * Members of sub objects are separated by '.', e.g. "type,header.routingKey".
+ * A path which ends at a sub object selects the whole sub object.
+ */
+class FieldMask {
+public:
+	FieldMask () : mAll (false) {}
+
+	/// Creates a mask from comma separated member paths
+	FieldMask (const char * paths);
+
+	/// Adds a member path
+	void add (const std::string & path);
+
+	/// Key is (at least partly) selected
+	bool contains (const char * name, int length) const;
+
+	/// Key is (at least partly) selected
+	bool contains (const char * name) const;
+
+	/// Returns the mask for the members of a sub object, 0 if the sub object is completely selected
+	const FieldMask * sub (const char * name) const;
+
+	/// Nothing is selected
+	bool empty () const { return mChildren.empty(); }
+
+private:
+	typedef std::map<std::string, FieldMask> MaskMap;
+	MaskMap mChildren;		///< Selected keys
+	bool mAll;				///< Selected as a whole (from a parent mask)
+};
+
+}
@@ -4,6 +4,11 @@
 #include <stdio.h>
 #include <assert.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SF_JSON_SSE2
+#endif
+
 namespace sf {
 namespace json {
 
@@ -11,13 +16,51 @@ static bool emptyChar (const char c) {
 	return (c == ' ' || c == '\n' || c == '\t' || c == '\f');
 }
 
+/// Checks whether text is valid UTF-8 (no overlong forms, no surrogates, nothing above U+10FFFF)
+static bool validUtf8 (const char * text, int length) {
+	const unsigned char * p   = (const unsigned char*) text;
+	const unsigned char * end = p + length;
+	while (p < end) {
+#ifdef SF_JSON_SSE2
+		// skip ASCII characters 16 at once
+		while (end - p >= 16 && _mm_movemask_epi8 (_mm_loadu_si128 ((const __m128i*) p)) == 0) {
+			p += 16;
+		}
+		if (p == end) break;
+#endif
+		unsigned char c = *p;
+		if (c < 0x80) { p++; continue; }
+		int following;
+		uint32_t code;
+		uint32_t minimum;
+		if ((c & 0xE0) == 0xC0)      { following = 1; code = c & 0x1F; minimum = 0x80; }
+		else if ((c & 0xF0) == 0xE0) { following = 2; code = c & 0x0F; minimum = 0x800; }
+		else if ((c & 0xF8) == 0xF0) { following = 3; code = c & 0x07; minimum = 0x10000; }
+		else return false;
+		if (end - p <= following) return false;
+		for (int i = 1; i <= following; i++) {
+			if ((p[i] & 0xC0) != 0x80) return false;
+			code = (code << 6) | (p[i] & 0x3F);
+		}
+		if (code < minimum || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) return false;
+		p += following + 1;
+	}
+	return true;
+}
+
 /// Scans for a string
 /// sbegin will point to the beginning of the string (a '"'), slength will be the length (including "..")
-static bool parseString (const char * text, int maxLength, int * slength){
+/// If flags is given, it will be set to the Value::Flags of the string
+/// With ValidateUtf8 in parseFlags the string is rejected if it is not valid UTF-8
+/// If hash is given, it will be set to the keyHash of the (undecoded) content
+static bool parseString (const char * text, int maxLength, int * slength, int * flags = 0, int parseFlags = 0, uint32_t * hash = 0){
 	bool escaped = false;	// escape sequence
 	bool began   = false;	// the string began yet
+	int stringFlags = 0;
+	uint32_t h = 2166136261u; // see keyHash
 	for (int i = 0; i < maxLength; i++) {
 		char c = text[i];
+		if (c & 0x80) stringFlags |= Value::NonAscii;
 		if (!began) {
 			if (c != '"') return false;
 
@@ -27,21 +70,33 @@ static bool parseString (const char * text, int maxLength, int * slength){
 		}
 		if (c == '"' && !escaped) {
 			// end of string
+			if ((parseFlags & ValidateUtf8) && (stringFlags & Value::NonAscii) && !validUtf8 (text + 1, i - 1)) return false;
 			*slength = i + 1;
+			if (flags) *flags = stringFlags;
+			if (hash) *hash = h;
 			return true;
 		}
-		escaped = false;
-
-		if (c == '\\') {
+		if (hash) {
+			h ^= (unsigned char) c;
+			h *= 16777619u;
+		}
+		if (c == '\\' && !escaped) {
 			escaped = true;
+			stringFlags |= Value::HasEscapes;
+		} else {
+			escaped = false;
 		}
 	}
 	return false; // region of the string ended
 }
 
 /// scans for begin and end of a object structure; obegin and olength will include the {..} braces
-bool scanObject (const char * text, int maxLength, int * olength) {
+/// With Validate all strings inside are checked to be valid UTF-8, otherwise no string
+/// content is tracked (the plain scanning loop)
+template <bool Validate> static bool scanObject (const char * text, int maxLength, int * olength) {
 	bool inString   = false;
+	bool nonAscii   = false; // current string contains non ASCII characters (only with Validate)
+	int stringBegin = 0;
 	bool escaped    = false; // if we are in a string and a '\' comes
 	int objectDepth = 0;
 	bool began = false;
@@ -58,13 +113,19 @@ bool scanObject (const char * text, int maxLength, int * olength) {
 		if (c == '"') {
 			if (!inString) {
 				inString = true;
+				if (Validate) {
+					nonAscii = false;
+					stringBegin = i;
+				}
 			}
 			else if (!escaped) {
 				inString = false;
+				if (Validate && nonAscii && !validUtf8 (text + stringBegin + 1, i - stringBegin - 1)) return false;
 			}
 		}
-		escaped = false;
-		if (c == '\\' && inString) { escaped = true; }
+		if (Validate && (c & 0x80)) nonAscii = true;
+		if (c == '\\' && inString && !escaped) { escaped = true; }
+		else escaped = false;
 
 		if (!inString) {
 			if (c == '{') objectDepth++;
@@ -80,8 +141,10 @@ bool scanObject (const char * text, int maxLength, int * olength) {
 	return false; // no end found
 }
 
-/// Scans for an array
-static bool scanArray (const char * text, int maxLength, int * alength){
+/// Scans for an array, see scanObject
+template <bool Validate> static bool scanArray (const char * text, int maxLength, int * alength){
+	bool nonAscii = false;
+	int stringBegin = 0;
 	bool began = false;
 	int arrayDepth = 0;
 	bool inString = false;
@@ -101,13 +164,19 @@ static bool scanArray (const char * text, int maxLength, int * alength){
 		if (c == '"') {
 			if (!inString) {
 				inString = true;
+				if (Validate) {
+					nonAscii = false;
+					stringBegin = i;
+				}
 			}
 			else if (!escaped) {
 				inString = false;
+				if (Validate && nonAscii && !validUtf8 (text + stringBegin + 1, i - stringBegin - 1)) return false;
 			}
 		}
-		escaped = false;
-		if (c == '\\' && inString) { escaped = true; }
+		if (Validate && (c & 0x80)) nonAscii = true;
+		if (c == '\\' && inString && !escaped) { escaped = true; }
+		else escaped = false;
 
 		if (!inString){
 			if (c == '[') arrayDepth++;
@@ -121,6 +190,18 @@ static bool scanArray (const char * text, int maxLength, int * alength){
 	return false;
 }
 
+/// Scans for an object, the validating scanner is only used with ValidateUtf8 in parseFlags
+static bool scanObject (const char * text, int maxLength, int * olength, int parseFlags) {
+	if (parseFlags & ValidateUtf8) return scanObject<true> (text, maxLength, olength);
+	return scanObject<false> (text, maxLength, olength);
+}
+
+/// Scans for an array, see scanObject
+static bool scanArray (const char * text, int maxLength, int * alength, int parseFlags) {
+	if (parseFlags & ValidateUtf8) return scanArray<true> (text, maxLength, alength);
+	return scanArray<false> (text, maxLength, alength);
+}
+
 /// Skips empty characters, text[position] will point to the first unempty
 /// Returns false on EOF
 static bool skipEmpty (const char * text, int begin, int maxLength, int * position){
@@ -176,6 +257,10 @@ static bool nextCompare (const char * text, int maxLength, const char * compare,
 		if (text[i] != *c) return false;
 		c++;
 	}
+	if (*c == 0) { // data ends directly after the word
+		*length = i;
+		return true;
+	}
 	return false; // end of line
 }
 
@@ -217,37 +302,135 @@ static bool parseNumber (const char * text, int maxLength, int * length, bool *
 	return began;
 }
 
-bool Value::fetch (std::string & string, bool doDecoding, bool * decodedSuccessfull) const {
-	if (mType == StringType){
+/// Finds the end of a value without converting it
+static bool skipValue (const char * text, int maxLength, int * length, int parseFlags = 0) {
+	if (maxLength <= 0) return false;
+	switch (*text) {
+		case '"': return parseString (text, maxLength, length, 0, parseFlags);
+		case '{': return scanObject (text, maxLength, length, parseFlags);
+		case '[': return scanArray (text, maxLength, length, parseFlags);
+		case 't': return nextCompare (text, maxLength, "true", length);
+		case 'f': return nextCompare (text, maxLength, "false", length);
+		case 'n': return nextCompare (text, maxLength, "null", length);
+	}
+	bool isFloat;
+	return parseNumber (text, maxLength, length, &isFloat);
+}
 
-		if (!doDecoding) {
-			string.resize(mLength - 2);
-			memcpy ((char*)string.c_str(), mData + 1, mLength - 2);
-			return true;
+/// Reads 4 hex digits
+static bool readHex4 (const char * text, uint32_t * value) {
+	uint32_t result = 0;
+	for (int i = 0; i < 4; i++) {
+		char c = text[i];
+		result <<= 4;
+		if (c >= '0' && c <= '9') result |= c - '0';
+		else if (c >= 'a' && c <= 'f') result |= c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F') result |= c - 'A' + 10;
+		else return false;
+	}
+	*value = result;
+	return true;
+}
+
+/// Appends a unicode code point in UTF-8
+static void appendUtf8 (std::string & dst, uint32_t c) {
+	char buffer [4];
+	int length;
+	if (c < 0x80) {
+		buffer[0] = (char) c;
+		length = 1;
+	} else if (c < 0x800) {
+		buffer[0] = (char) (0xC0 | (c >> 6));
+		buffer[1] = (char) (0x80 | (c & 0x3F));
+		length = 2;
+	} else if (c < 0x10000) {
+		buffer[0] = (char) (0xE0 | (c >> 12));
+		buffer[1] = (char) (0x80 | ((c >> 6) & 0x3F));
+		buffer[2] = (char) (0x80 | (c & 0x3F));
+		length = 3;
+	} else {
+		buffer[0] = (char) (0xF0 | (c >> 18));
+		buffer[1] = (char) (0x80 | ((c >> 12) & 0x3F));
+		buffer[2] = (char) (0x80 | ((c >> 6) & 0x3F));
+		buffer[3] = (char) (0x80 | (c & 0x3F));
+		length = 4;
+	}
+	dst.append (buffer, length);
+}
+
+/// Decodes the content of a JSON string (without quotes), appends it to dst
+/// Invalid escape sequences are skipped (invalid \u sequences get U+FFFD)
+/// @return false if there were invalid escape sequences
+static bool decodeString (const char * text, int length, std::string & dst) {
+	bool suc = true;
+	const char * end = text + length;
+	const char * p   = text;
+	while (p < end) {
+		// copy everything until the next escape sequence at once
+		const char * escape = (const char*) memchr (p, '\\', end - p);
+		if (!escape) {
+			dst.append (p, end - p);
+			break;
 		}
-		if (decodedSuccessfull) *decodedSuccessfull = true;
-		bool escaped = false;
-		string.clear();
-		string.reserve (mLength - 1);
-		for (int i = 1; i < mLength - 1; i++){
-			char c = mData[i];
-			if (escaped) {
-				if (c == '\"') string.append(1, '\"');
-				else if (c == '\\') string.append(1, '\\');
-				else if (c == 'b')  string.append(1, '\b');
-				else if (c == 'f')  string.append(1, '\f');
-				else if (c == 'n')  string.append(1, '\n');
-				else if (c == 'r')  string.append(1, '\r');
-				else if (c == 't')  string.append(1, '\t');
-				else {
-					*decodedSuccessfull = false;
+		dst.append (p, escape - p);
+		p = escape + 1;
+		if (p == end) return false;
+		char c = *p++;
+		switch (c) {
+			case '"':  dst.push_back ('"'); break;
+			case '\\': dst.push_back ('\\'); break;
+			case '/':  dst.push_back ('/'); break;
+			case 'b':  dst.push_back ('\b'); break;
+			case 'f':  dst.push_back ('\f'); break;
+			case 'n':  dst.push_back ('\n'); break;
+			case 'r':  dst.push_back ('\r'); break;
+			case 't':  dst.push_back ('\t'); break;
+			case 'u': {
+				uint32_t code;
+				if (end - p < 4 || !readHex4 (p, &code)) {
+					suc = false;
+					break;
 				}
-				escaped = false;
-			} else {
-				if (c == '\\') escaped = true;
-				else string.append (1, c);
+				p += 4;
+				if (code >= 0xD800 && code <= 0xDBFF) {
+					// high surrogate, must be followed by a low surrogate
+					uint32_t low;
+					if (end - p >= 6 && p[0] == '\\' && p[1] == 'u' && readHex4 (p + 2, &low) && low >= 0xDC00 && low <= 0xDFFF) {
+						code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+						p += 6;
+					} else {
+						code = 0xFFFD;
+						suc = false;
+					}
+				} else if (code >= 0xDC00 && code <= 0xDFFF) {
+					// lonely low surrogate
+					code = 0xFFFD;
+					suc = false;
+				}
+				appendUtf8 (dst, code);
 			}
+			break;
+			default:
+				suc = false;
+		}
+	}
+	return suc;
+}
+
+bool Value::fetch (std::string & string, bool doDecoding, bool * decodedSuccessfull) const {
+	if (mType == StringType){
+		const char * content = mData + 1;
+		int length = mLength - 2;
+		// escape sequences are plain ASCII and decode to valid UTF-8, so only checking the raw content is enough
+		if (decodedSuccessfull) *decodedSuccessfull = !doDecoding || !(mFlags & NonAscii) || validUtf8 (content, length);
+		if (!doDecoding || !(mFlags & HasEscapes)) {
+			string.assign (content, length);
+			return true;
 		}
+		string.clear();
+		string.reserve (length);
+		bool suc = decodeString (content, length, string);
+		if (decodedSuccessfull && !suc) *decodedSuccessfull = false;
 		return true;
 	}
 	return false;
@@ -281,9 +464,9 @@ bool Value::fetch (bool & data) const {
 	return false;
 }
 
-bool Value::fetch (Object & parser) const {
+bool Value::fetch (Object & parser, const FieldMask * mask) const {
 	if (mType != ObjectType) return false;
-	parser.init (mData, mLength);
+	parser.init (mData, mLength, mask);
 	return !parser.error();
 }
 
@@ -293,6 +476,12 @@ bool Value::fetch (Array & array) const {
 	return !array.error();
 }
 
+bool Value::fetch (LazyArray & array) const {
+	if (mType != ArrayType) return false;
+	array.init (mData, mLength);
+	return !array.error();
+}
+
 bool Value::numFetch (int64_t & data) const {
 	if(mType == IntType) {
 		data = iData;
@@ -357,21 +546,22 @@ bool Value::numFetch (double & data) const {
 	return false;
 }
 
-bool Value::parse (const char * text, int maxLength){
+bool Value::parse (const char * text, int maxLength, int parseFlags){
 	if (maxLength <= 0) return false;
 
 	mData = text;
 
 
-	if (*mData == '"' && parseString (mData, maxLength, &mLength)){
+	mFlags = 0;
+	if (*mData == '"' && parseString (mData, maxLength, &mLength, &mFlags, parseFlags)){
 		mType = StringType;
 		return true;
 	}
-	if (*mData == '{' && scanObject (mData, maxLength, &mLength)){
+	if (*mData == '{' && scanObject (mData, maxLength, &mLength, parseFlags)){
 		mType = ObjectType;
 		return true;
 	}
-	if (*mData == '[' && scanArray (mData, maxLength, &mLength)){
+	if (*mData == '[' && scanArray (mData, maxLength, &mLength, parseFlags)){
 		mType = ArrayType;
 		return true;
 	}
@@ -391,12 +581,21 @@ bool Value::parse (const char * text, int maxLength){
 	}
 	bool isFloat;
 	if (parseNumber (mData, maxLength, &mLength, &isFloat)){
+		const char * number = mData;
+		char buffer [64];
+		if (mLength == maxLength) {
+			// number ends with the data, which doesn't need to be null terminated (e.g. mapped files)
+			if (mLength >= (int) sizeof (buffer)) return false;
+			memcpy (buffer, mData, mLength);
+			buffer[mLength] = 0;
+			number = buffer;
+		}
 		errno = 0; // maybe tainted (it has happend!)
 		if (isFloat){
-			fData = strtod (mData, NULL);
+			fData = strtod (number, NULL);
 			mType = FloatType;
 		} else {
-			iData = strtol (mData, NULL, 10);
+			iData = strtol (number, NULL, 10);
 			mType = IntType;
 		}
 		return !errno;
@@ -459,6 +658,169 @@ void Array::parse (const char * data, int length) {
 	return;
 }
 
+ArrayIterator::ArrayIterator (const char * data, int length, bool * error) : mData (data), mLength (length), mPosition (-1), mError (error) {
+	int i;
+	if (length <= 0 || data[0] != '[' || !skipEmpty (data, 1, length, &i)) { fail (); return; }
+	if (data[i] == ']') return; // empty
+	read (i);
+}
+
+ArrayIterator & ArrayIterator::operator++ () {
+	if (mPosition < 0) return *this;
+	int p;
+	if (!skipEmpty (mData, mPosition + mValue.mLength, mLength, &p)) { fail (); return *this; }
+	if (mData[p] == ']') { mPosition = -1; return *this; }
+	if (mData[p] != ',' || !skipEmpty (mData, p + 1, mLength, &p)) { fail (); return *this; }
+	if (mData[p] == ']') { mPosition = -1; return *this; } // can also end after ','
+	read (p);
+	return *this;
+}
+
+void ArrayIterator::read (int p) {
+	if (!mValue.parse (mData + p, mLength - p)) { fail (); return; }
+	mPosition = p;
+}
+
+void ArrayIterator::fail () {
+	if (mError) *mError = true;
+	mPosition = -1;
+}
+
+ArrayRange::ArrayRange (const Value & v) : mData (v.mData), mLength (v.mLength), mError (v.type() != ArrayType) {
+	if (mError) mLength = 0;
+}
+
+ObjectIterator::ObjectIterator (const char * data, int length, bool * error) : mData (data), mLength (length), mPosition (-1), mNext (0), mError (error) {
+	if (length <= 0 || data[0] != '{') { fail (); return; }
+	read (1);
+}
+
+ObjectIterator & ObjectIterator::operator++ () {
+	if (mPosition < 0) return *this;
+	read (mNext);
+	return *this;
+}
+
+void ObjectIterator::read (int p) {
+	int i = p;
+	for (;;) {
+		if (!skipEmpty (mData, i, mLength, &i)) { fail (); return; }
+		if (mData[i] == '}') { mPosition = -1; return; }
+		if (mData[i] != ',') break;
+		i++;
+	}
+	int length;
+	if (!parseString (mData + i, mLength - i, &length, 0, 0, &mEntry.mHash)) { fail (); return; }
+	mEntry.mName       = mData + i + 1;
+	mEntry.mNameLength = length - 2; // without doublequotes
+	int begin = i;
+	if (!awaitCharacter (mData, i + length, mLength, ':', &i)) { fail (); return; }
+	if (!skipEmpty (mData, i + 1, mLength, &i)) { fail (); return; }
+	if (!mEntry.mValue.parse (mData + i, mLength - i)) { fail (); return; }
+	mPosition = begin;
+	mNext     = i + mEntry.mValue.mLength;
+}
+
+void ObjectIterator::fail () {
+	if (mError) *mError = true;
+	mPosition = -1;
+}
+
+ObjectRange::ObjectRange (const Value & v) : mData (v.mData), mLength (v.mLength), mError (v.type() != ObjectType) {
+	if (mError) mLength = 0;
+}
+
+void LazyArray::init (const char * data, int length) {
+	mData         = data;
+	mLength       = length;
+	mError        = false;
+	mComplete     = false;
+	mScanned      = 0;
+	mScanPosition = 0;
+	mCursor       = -1;
+	mCheckpoints.clear ();
+	int i;
+	if (length <= 0 || data[0] != '[' || !skipEmpty (data, 1, length, &i)) {
+		mError    = true;
+		mComplete = true;
+		return;
+	}
+	if (data[i] == ']') {
+		mComplete = true;
+		return;
+	}
+	mScanPosition = i;
+	mCheckpoints.push_back (i);
+}
+
+Value LazyArray::get (int id) const {
+	Value v;
+	int position;
+	if (!elementPosition (id, &position)) return v;
+	if (!v.parse (mData + position, mLength - position)) mError = true;
+	mCursor         = id;
+	mCursorPosition = position;
+	return v;
+}
+
+int LazyArray::count () const {
+	while (!mComplete) advance ();
+	return mScanned;
+}
+
+bool LazyArray::elementPosition (int id, int * position) const {
+	if (id < 0) return false;
+	while (!mComplete && mScanned < id) advance ();
+	if (id == mScanned && !mComplete) {
+		*position = mScanPosition;
+		return true;
+	}
+	if (id >= mScanned) return false;
+	// already scanned, start from the cursor or the nearest checkpoint
+	int checkpoint = id / Stride;
+	int current  = checkpoint * Stride;
+	int p        = mCheckpoints[checkpoint];
+	if (mCursor >= current && mCursor <= id) {
+		current = mCursor;
+		p       = mCursorPosition;
+	}
+	for (; current < id; current++) {
+		if (step (&p) != 1) return false;
+	}
+	*position = p;
+	return true;
+}
+
+void LazyArray::advance () const {
+	int p = mScanPosition;
+	int result = step (&p);
+	if (result < 0) {
+		mError    = true;
+		mComplete = true;
+		return;
+	}
+	mScanned++;
+	if (result == 0) {
+		mComplete = true;
+		return;
+	}
+	mScanPosition = p;
+	if (mScanned % Stride == 0) mCheckpoints.push_back (p);
+}
+
+int LazyArray::step (int * position) const {
+	int length;
+	if (!skipValue (mData + *position, mLength - *position, &length)) return -1;
+	int p;
+	if (!skipEmpty (mData, *position + length, mLength, &p)) return -1;
+	if (mData[p] == ']') return 0;
+	if (mData[p] != ',') return -1;
+	if (!skipEmpty (mData, p + 1, mLength, &p)) return -1;
+	if (mData[p] == ']') return 0; // can also end after ','
+	*position = p;
+	return 1;
+}
+
 Object::Object (const Object & object) {
 	operator=(object);
 }
@@ -499,7 +861,7 @@ void Object::init (const char * data, std::string & command, int length){
 	init (data + cmdEnd, length - cmdEnd);
 }
 
-void Object::parse () {
+void Object::parse (const FieldMask * mask, int parseFlags) {
 	enum State { 
 		Begin,				// Waiting for beginning { 
 		AwaitingKey, 		// Waiting for beginning key or for ending structure
@@ -530,7 +892,7 @@ void Object::parse () {
 				if (c == ',') { i++; continue; }
 				if (c == '}') { i++; goto EndCheck; }
 				int length;
-				if (parseString (mData + i, mLength - i, &length)) {
+				if (parseString (mData + i, mLength - i, &length, 0, parseFlags, &entry.mHash)) {
 					assert (length >= 2); // must be ".."
 					entry.mName = mData + i + 1;
 					entry.mNameLength = length - 2; // without doublequotes
@@ -545,7 +907,15 @@ void Object::parse () {
 			}
 			break;
 			case AwaitingValue : {
-				bool found = entry.mValue.parse (mData + i, mLength - i);
+				if (mask && !mask->contains (entry.mName, entry.mNameLength)) {
+					// not selected, just skip it
+					int length;
+					if (!skipValue (mData + i, mLength - i, &length, parseFlags)) goto ErrorCase;
+					i += length;
+					state = AwaitingKey;
+					continue;
+				}
+				bool found = entry.mValue.parse (mData + i, mLength - i, parseFlags);
 				i+=entry.mValue.mLength;
 				if (!found) goto ErrorCase;
 				mEntries.insertEntry (entry);
@@ -620,13 +990,170 @@ Value parse (const char * data, std::string & command, int length) {
 	return parse (data + bracePos, length - bracePos);
 }
 
-Value parse (const char * data, int length) {
+Value parse (const char * data, int length, int parseFlags) {
 	if (length < 0) length = strlen (data);
 	Value v;
-	v.parse (data, length);
+	v.parse (data, length, parseFlags);
 	return v;
 }
 
+/// Parses a JSON Pointer reference token (until '/' or end) and unescapes ~0 and ~1
+static bool parseReferenceToken (const char * text, std::string * token, int * length) {
+	int i = 0;
+	token->clear ();
+	for (; text[i] != 0 && text[i] != '/'; i++) {
+		if (text[i] == '~') {
+			if (text[i+1] == '0') token->push_back ('~');
+			else if (text[i+1] == '1') token->push_back ('/');
+			else return false;
+			i++;
+		} else {
+			token->push_back (text[i]);
+		}
+	}
+	*length = i;
+	return true;
+}
+
+/// Converts a reference token to an array index, -1 if it is none
+static int arrayIndex (const std::string & token) {
+	if (token.empty() || token.length() > 9) return -1;
+	if (token.length() > 1 && token[0] == '0') return -1; // no leading zeros
+	int result = 0;
+	for (size_t i = 0; i < token.length(); i++) {
+		if (token[i] < '0' || token[i] > '9') return -1;
+		result = result * 10 + (token[i] - '0');
+	}
+	return result;
+}
+
+const PathQuery::Node * PathQuery::Node::find (const char * key, int length) const {
+	for (std::vector<Node>::const_iterator i = children.begin(); i != children.end(); i++) {
+		if ((int) i->token.length() == length && memcmp (i->token.c_str(), key, length) == 0) return &*i;
+	}
+	return 0;
+}
+
+const PathQuery::Node * PathQuery::Node::find (int index) const {
+	for (std::vector<Node>::const_iterator i = children.begin(); i != children.end(); i++) {
+		if (i->index == index) return &*i;
+	}
+	return 0;
+}
+
+int PathQuery::add (const char * pointer) {
+	if (*pointer != 0 && *pointer != '/') return -1;
+	// validate first, so that invalid pointers do not leave nodes
+	std::vector<std::string> tokens;
+	const char * p = pointer;
+	while (*p == '/') {
+		std::string token;
+		int length;
+		if (!parseReferenceToken (p + 1, &token, &length)) return -1;
+		tokens.push_back (token);
+		p += length + 1;
+	}
+	Node * node = &mRoot;
+	for (std::vector<std::string>::const_iterator i = tokens.begin(); i != tokens.end(); i++) {
+		Node * child = 0;
+		for (std::vector<Node>::iterator j = node->children.begin(); j != node->children.end(); j++) {
+			if (j->token == *i) { child = &*j; break; }
+		}
+		if (!child) {
+			node->children.push_back (Node ());
+			child = &node->children.back();
+			child->token = *i;
+			child->index = arrayIndex (*i);
+		}
+		node = child;
+	}
+	if (node->result < 0) node->result = mCount++;
+	return node->result;
+}
+
+void PathQuery::run (const char * data, int length, std::vector<Value> & results) const {
+	if (length < 0) length = strlen (data);
+	results.clear ();
+	results.resize (mCount);
+	int begin;
+	if (!skipEmpty (data, 0, length, &begin)) return;
+	visit (mRoot, data + begin, length - begin, results);
+}
+
+void PathQuery::run (const Value & root, std::vector<Value> & results) const {
+	results.clear ();
+	results.resize (mCount);
+	if (!root.valid()) return;
+	visit (mRoot, root.mData, root.mLength, results);
+}
+
+/// Handles a value whose path is matching node
+void PathQuery::visit (const Node & node, const char * text, int length, std::vector<Value> & results) const {
+	if (node.result >= 0) results[node.result].parse (text, length);
+	if (node.children.empty() || length <= 0) return;
+	if (*text == '{') walkObject (node, text, length, results);
+	if (*text == '[') walkArray (node, text, length, results);
+}
+
+void PathQuery::walkObject (const Node & node, const char * text, int maxLength, std::vector<Value> & results) const {
+	int found = 0;
+	int i = 1;
+	while (found < (int) node.children.size()) {
+		if (!skipEmpty (text, i, maxLength, &i)) return;
+		if (text[i] == '}') return;
+		if (text[i] == ',') { i++; continue; }
+		int length;
+		if (!parseString (text + i, maxLength - i, &length)) return;
+		const Node * child = node.find (text + i + 1, length - 2);
+		i += length;
+		if (!awaitCharacter (text, i, maxLength, ':', &i)) return;
+		if (!skipEmpty (text, i + 1, maxLength, &i)) return;
+		if (!skipValue (text + i, maxLength - i, &length)) return;
+		if (child) {
+			visit (*child, text + i, length, results);
+			found++;
+		}
+		i += length;
+	}
+}
+
+void PathQuery::walkArray (const Node & node, const char * text, int maxLength, std::vector<Value> & results) const {
+	int found = 0;
+	int index = 0;
+	int i = 1;
+	while (found < (int) node.children.size()) {
+		if (!skipEmpty (text, i, maxLength, &i)) return;
+		if (text[i] == ']') return;
+		int length;
+		if (!skipValue (text + i, maxLength - i, &length)) return;
+		const Node * child = node.find (index);
+		if (child) {
+			visit (*child, text + i, length, results);
+			found++;
+		}
+		i += length;
+		index++;
+		if (!skipEmpty (text, i, maxLength, &i)) return;
+		if (text[i] == ',') i++;
+	}
+}
+
+Value query (const Value & root, const char * pointer) {
+	PathQuery q;
+	if (q.add (pointer) < 0) return Value ();
+	std::vector<Value> results;
+	q.run (root, results);
+	return results[0];
+}
+
+Value query (const char * data, int length, const char * pointer) {
+	PathQuery q;
+	if (q.add (pointer) < 0) return Value ();
+	std::vector<Value> results;
+	q.run (data, length, results);
+	return results[0];
+}
+
 }
 }
 
@@ -8,10 +8,11 @@
  * (It shall be easy to put in, just look into the json::Object class)
  *
  * @Note:
- * - There is no support for the @\u escape sequence.
+ * - Strings are decoded including @\u escape sequences (surrogate pairs are converted to UTF-8).
  * - For key names there is no support for escapes at all.
- * - Decoding of strings with escape sequences (fetch (name, string, true)) may be very slow.
  * - The parser has to be only dependent on standard C++ Stuff, no boost, no other libs.
+ * - UTF-8 is only checked when fetching strings, with the ValidateUtf8 flag the parser
+ *   rejects invalid UTF-8 in all strings during the (structural) parsing pass already.
  *
  * The main class is json::Object, just feed it with your JSON code and access all elements via get() and fetch ()
  *
@@ -24,6 +25,8 @@
 #include <string>
 #include <vector>
 #include <ostream>
+#include "FieldMask.h"
+#include "StringView.h"
 
 #ifdef WIN32
 #include "winsupport.h"
@@ -41,19 +44,65 @@ enum ValueType {
 	InvalidType = 0, ObjectType, IntType, FloatType, StringType, BoolType, NullType, ArrayType
 };
 
+///@endcond DEV
+
+/// Hash of a key name (FNV-1a), the parser calculates it while scanning the keys
+inline uint32_t keyHash (const char * name, int length) {
+	uint32_t hash = 2166136261u;
+	for (int i = 0; i < length; i++) {
+		hash ^= (unsigned char) name[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/// A key name together with its length and keyHash, for fast lookups.
+/// sfautoreflect generates them as constants.
+struct Key {
+	Key (const char * name) : name (name), length ((int) strlen (name)), hash (keyHash (name, length)) {}
+	Key (const char * name, int length, uint32_t hash) : name (name), length (length), hash (hash) {}
+
+	const char * name;	///< 0-terminated name
+	int length;			///< Length of name
+	uint32_t hash;		///< keyHash of name
+};
+
+/// Flags for parsing JSON code
+enum ParseFlags {
+	ValidateUtf8 = 0x1	///< Reject strings (keys and values, also nested ones) which are not valid UTF-8
+};
+
+///@cond DEV
+
 class Object;
 class Array;
+class LazyArray;
 
 /// A JSON Value
 class Value {
 public:
-	Value () : mData (0), mLength (0), mType(InvalidType) {}
+	Value () : mData (0), mLength (0), mFlags (0), mType(InvalidType) {}
+
+	/// Properties of string values, recorded while scanning
+	enum Flags {
+		HasEscapes = 0x1,	///< String contains escape sequences
+		NonAscii   = 0x2	///< String contains bytes >= 0x80
+	};
 
 	/// Fetches an string
 	/// @param doDecoding do decoding of escape sequences
+	/// @param decodedSuccessfull set to false if there were invalid escape sequences or invalid UTF-8 (only checked when decoding)
 	/// @return whether type was Ok
 	bool fetch (std::string & string, bool doDecoding = false, bool * decodedSuccessfull = 0) const;
 
+	/// Fetches a string without copying it, escape sequences are not decoded (see hasEscapes)
+	/// @return whether type was Ok
+	bool fetch (StringView & view) const {
+		if (mType != StringType) return false;
+		view = StringView (mData + 1, mLength - 2);
+		return true;
+	}
+
 	/// Fetches an long int type.
 	/// @return whether type was Ok
 	bool fetch (int64_t & data) const;
@@ -77,13 +126,18 @@ public:
 	bool fetch (bool & data) const;
 
 	/// Fetches a a sub object.
+	/// If a mask is given, only the selected keys will be parsed
 	/// @return whether type was Ok and the parser could parse the subtype.
-	bool fetch (Object & parser) const;
+	bool fetch (Object & parser, const FieldMask * mask = 0) const;
 
 	/// Fetches an array
 	/// @return whether type was Ok and the array was successfully parsed
 	bool fetch (Array & array) const;
 
+	/// Fetches an array, which is scanned on demand
+	/// @return whether type was Ok
+	bool fetch (LazyArray & array) const;
+
 	/// Fetches an numerical type (do not cars about int/float/string)
 	/// @return whether type was Ok
 	bool numFetch (int64_t & data) const;
@@ -104,6 +158,12 @@ public:
 	/// Value is a valid type
 	bool valid () const { return mType != InvalidType; }
 
+	/// String value contains escape sequences (otherwise it can be used without decoding)
+	bool hasEscapes () const { return (mFlags & HasEscapes) != 0; }
+
+	/// String value consists of ASCII characters only (and needs no UTF-8 validation)
+	bool isAscii () const { return (mFlags & NonAscii) == 0; }
+
 	/// Fetches a a sub object.
 	/// @return when name was found, type was Ok and the parser could parse the subtype.
 	bool fetchSubObject (Object & parser) const { return fetch (parser); }
@@ -111,7 +171,8 @@ public:
 	///@cond DEV
 
 	/// Parses a value; returns true on success
-	bool parse (const char * text, int maxLength);
+	/// @param parseFlags see ParseFlags
+	bool parse (const char * text, int maxLength, int parseFlags = 0);
 
 	/// Returns error state (means invalid type)
 	bool error () const { return mType == InvalidType; }
@@ -127,8 +188,14 @@ public:
 private:
 	friend class Object;
 	friend class Array;
+	friend class PathQuery;
+	friend class ArrayIterator;
+	friend class ObjectIterator;
+	friend class ArrayRange;
+	friend class ObjectRange;
 	const char * mData;		///< Position where the entry relies
 	int mLength;			///< Length of the value field
+	int mFlags;				///< Flags of string values
 	union {
 		double fData;		///< Double data (if type == FloatType)
 		int64_t iData;			///< Integer data (if type == IntType)
@@ -141,18 +208,24 @@ private:
 /// A stored name value pair
 class Entry {
 public:
-	Entry () : mName (0), mNext (0) {}
+	Entry () : mName (0), mNameLength (0), mHash (0), mNext (0) {}
 
 	/// Returns the name of the entry
 	std::string name () const { return std::string (mName, mName + mNameLength); }
+	/// Returns the name of the entry without copying it
+	StringView nameView () const { return StringView (mName, mNameLength); }
+	/// Returns the keyHash of the name
+	uint32_t nameHash () const { return mHash; }
 	/// Returns the value of the entry.
 	const Value & value () const { return mValue; }
 	/// Returns the next entry, or 0 if there is no next
 	const Entry* next () const { return mNext; }
 private:
 	friend class Object;
+	friend class ObjectIterator;
 	const char * mName;		///< Name of the key (not 0-terminated)
 	int mNameLength;		///< Length of the key
+	uint32_t mHash;			///< keyHash of the key
 	Value mValue;
 	Entry * mNext;			///< Next entry
 };
@@ -189,6 +262,164 @@ private:
 };
 
 
+/**
+ * Iterates over the values of a JSON array while scanning it, no value vector is built.
+ * Leaving the loop early stops the scanning. Errors end the iteration (see ArrayRange::error).
+ *
+ * @verbatim
+	json::ArrayRange elements (value);
+	for (json::ArrayIterator i = elements.begin(); i != elements.end(); ++i) {
+		i->fetch (...);
+	}
+	if (elements.error()) ...
+ * @endverbatim
+ */
+class ArrayIterator {
+public:
+	/// End iterator
+	ArrayIterator () : mData (0), mLength (0), mPosition (-1), mError (0) {}
+	/// Iterator to the first value of an array (error will be set on errors)
+	ArrayIterator (const char * data, int length, bool * error);
+
+	const Value & operator* () const { return mValue; }
+	const Value * operator-> () const { return &mValue; }
+	ArrayIterator & operator++ ();
+
+	bool operator== (const ArrayIterator & other) const { return mPosition == other.mPosition; }
+	bool operator!= (const ArrayIterator & other) const { return mPosition != other.mPosition; }
+private:
+	/// Reads the value at position p
+	void read (int p);
+	/// Marks an error and ends the iteration
+	void fail ();
+
+	const char * mData;
+	int   mLength;
+	int   mPosition;	///< Position of the current value, -1 at the end
+	Value mValue;
+	bool * mError;
+};
+
+/// The values of a JSON array for iteration (usable in range based for loops)
+class ArrayRange {
+public:
+	/// Values of an array value (error if it is no array)
+	ArrayRange (const Value & v);
+	/// Values of JSON code containing an array
+	ArrayRange (const char * data, int length) : mData (data), mLength (length), mError (false) {}
+
+	ArrayIterator begin () const { return ArrayIterator (mData, mLength, &mError); }
+	ArrayIterator end () const { return ArrayIterator (); }
+
+	/// The array could not be scanned (completely)
+	bool error () const { return mError; }
+private:
+	const char * mData;
+	int mLength;
+	mutable bool mError;
+};
+
+/**
+ * Iterates over the entries of a JSON object while scanning it, no entry table is built.
+ * Leaving the loop early stops the scanning. Errors end the iteration (see ObjectRange::error).
+ */
+class ObjectIterator {
+public:
+	/// End iterator
+	ObjectIterator () : mData (0), mLength (0), mPosition (-1), mNext (0), mError (0) {}
+	/// Iterator to the first entry of an object (error will be set on errors)
+	ObjectIterator (const char * data, int length, bool * error);
+
+	const Entry & operator* () const { return mEntry; }
+	const Entry * operator-> () const { return &mEntry; }
+	ObjectIterator & operator++ ();
+
+	bool operator== (const ObjectIterator & other) const { return mPosition == other.mPosition; }
+	bool operator!= (const ObjectIterator & other) const { return mPosition != other.mPosition; }
+private:
+	/// Reads the next entry beginning at p (or the end of the object)
+	void read (int p);
+	/// Marks an error and ends the iteration
+	void fail ();
+
+	const char * mData;
+	int   mLength;
+	int   mPosition;	///< Position of the current entry, -1 at the end
+	int   mNext;		///< Position after the current entry
+	Entry mEntry;
+	bool * mError;
+};
+
+/// The entries of a JSON object for iteration (usable in range based for loops)
+class ObjectRange {
+public:
+	/// Entries of an object value (error if it is no object)
+	ObjectRange (const Value & v);
+	/// Entries of JSON code containing an object
+	ObjectRange (const char * data, int length) : mData (data), mLength (length), mError (false) {}
+
+	ObjectIterator begin () const { return ObjectIterator (mData, mLength, &mError); }
+	ObjectIterator end () const { return ObjectIterator (); }
+
+	/// The object could not be scanned (completely)
+	bool error () const { return mError; }
+private:
+	const char * mData;
+	int mLength;
+	mutable bool mError;
+};
+
+/**
+ * A JSON Array which is scanned on demand.
+ *
+ * In contrast to Array it does not create all values in advance, it only stores the
+ * position of every Stride-th element while scanning. Sequential access (get (i) after get (i-1))
+ * continues where the last access stopped, so iterating needs no value vector at all.
+ * Random access scans at most Stride elements from the nearest checkpoint.
+ */
+class LazyArray {
+public:
+	LazyArray () : mData (0), mLength (0), mError (true), mComplete (true), mScanned (0), mScanPosition (0), mCursor (-1), mCursorPosition (0) {}
+
+	/// Initializes an array, does not copy the data
+	LazyArray (const char * data, int length) { init (data, length); }
+
+	/// (Re-)initializes the array, it will only check the beginning
+	void init (const char * data, int length);
+
+	/// Returns error state (errors are detected while scanning)
+	bool error () const { return mError; }
+
+	/// Access to the entries, returns an invalid value if there is no such entry
+	Value get (int id) const;
+
+	/// How many entries are in the array (scans the whole array)
+	int count () const;
+
+private:
+	///@cond DEV
+	enum { Stride = 32 };
+
+	/// Finds the position of an element
+	bool elementPosition (int id, int * position) const;
+	/// Scans the element at the scan position
+	void advance () const;
+	/// Moves from the beginning of an element to the beginning of the next one
+	/// Returns 1 on success, 0 on the end of the array, -1 on errors
+	int step (int * position) const;
+
+	const char * mData;
+	int mLength;
+	mutable bool mError;
+	mutable bool mComplete;					///< The whole array has been scanned
+	mutable int  mScanned;					///< Number of scanned elements (if complete, the count of elements)
+	mutable int  mScanPosition;				///< Position of element mScanned (if not complete)
+	mutable std::vector<int> mCheckpoints;	///< Positions of the elements 0, Stride, 2 * Stride, ...
+	mutable int  mCursor;					///< Last accessed element
+	mutable int  mCursorPosition;			///< Position of last accessed element
+	///@endcond DEV
+};
+
 /**
  * A JSON Object (something with "{" .. "}")
  *
@@ -254,18 +485,20 @@ public:
 	/**
 	 * (Re-)initializes the parser and parses the code. If length == -1 it assumes the data to be 
 	 * null-terminated otherwise it uses the given length.
+	 * If a mask is given, values of other keys are skipped and not stored.
+	 * parseFlags are a combination of ParseFlags (skipped values are validated, too).
 	 *
 	 * @note
 	 * - Object does not hold a copy of the text. It uses the given one.
 	 */
-	void init (const char * data, int length = -1){
+	void init (const char * data, int length = -1, const FieldMask * mask = 0, int parseFlags = 0){
 		mEntries.clear ();
 		mEntries.reserve (32);
 		mData = data;
 		mLength = length < 0 ? strlen (data) : length;
 		mError = false;
 		mErrorMessage = "";
-		parse ();
+		parse (mask, parseFlags);
 	}
 	
 	/**
@@ -281,9 +514,15 @@ public:
 	///@name Field Access
 	///@{
 	
-	/// Fetches a value with the given key. Returns 0 if nothing found
+	/// Fetches a value with the given key. Returns an invalid value if nothing found
 	const Value & get (const char * name) const {
-		const Entry * e = mEntries.findEntry (name);
+		return get (Key (name));
+	}
+
+	/// Fetches a value with the given key (name, length and hash precalculated).
+	/// Returns an invalid value if nothing found
+	const Value & get (const Key & key) const {
+		const Entry * e = mEntries.findEntry (key);
 		static Value invalidValue; // default initializes to invalid
 		return e ? e->value() : invalidValue;
 	}
@@ -306,13 +545,13 @@ private:
 	/// Table of entries with search options via name
 	/// Replace this table in order to use a HashMap
 	struct EntryTable : private std::vector<Entry> {
-		const Entry * findEntry (const char * name) const {
+		const Entry * findEntry (const Key & key) const {
 			EntryTable::const_iterator i;
-			int l = (int) strlen (name);
 			for (i = begin(); i != end(); i++){
 				const Entry & e = *i;
-				if (e.mNameLength != l) continue; // the name is saved with double quotes ("..")
-				if (strncmp (e.mName, name, l) == 0) return &e;
+				// the hash nearly always decides
+				if (e.mHash != key.hash || e.mNameLength != key.length) continue;
+				if (memcmp (e.mName, key.name, key.length) == 0) return &e;
 			}
 			return 0;
 		}
@@ -360,16 +599,79 @@ private:
 	std::string mErrorMessage;
 	
 	/// Parses the JSON file
-	void parse ();
+	void parse (const FieldMask * mask, int parseFlags);
 };
 
+/**
+ * Queries values by JSON Pointer (RFC 6901), e.g. "/orders/17/price".
+ *
+ * The query walks the raw JSON code, only containers on the paths are looked into,
+ * everything else is skipped using the structural scanners. Multiple paths are
+ * collected in one pass.
+ *
+ * @verbatim
+	json::PathQuery query;
+	int price = query.add ("/orders/17/price");
+	int user  = query.add ("/user/name");
+	std::vector<json::Value> results;
+	query.run (json.c_str(), json.length(), results);
+	results[price].fetch (...)
+ * @endverbatim
+ */
+class PathQuery {
+public:
+	PathQuery () : mCount (0) {}
+
+	/// Adds a JSON Pointer, returns the index of its result (-1 if it is not a valid pointer)
+	int add (const char * pointer);
+
+	/// Number of added paths
+	int count () const { return mCount; }
+
+	/// Evaluates all paths on the JSON code; not found paths result in invalid values
+	void run (const char * data, int length, std::vector<Value> & results) const;
+
+	/// Evaluates all paths inside a value (relative to it)
+	void run (const Value & root, std::vector<Value> & results) const;
+
+private:
+	///@cond DEV
+	/// A reference token of the paths
+	struct Node {
+		Node () : index (-1), result (-1) {}
+		std::string token;			///< Unescaped reference token
+		int index;					///< Token as array index (or -1)
+		int result;					///< Result index if a path ends here (or -1)
+		std::vector<Node> children;
+
+		const Node * find (const char * key, int length) const;
+		const Node * find (int index) const;
+	};
+	///@endcond DEV
+
+	void visit (const Node & node, const char * text, int length, std::vector<Value> & results) const;
+	void walkObject (const Node & node, const char * text, int maxLength, std::vector<Value> & results) const;
+	void walkArray (const Node & node, const char * text, int maxLength, std::vector<Value> & results) const;
+
+	Node mRoot;
+	int  mCount;	///< Number of paths
+};
+
+/// Returns the value at a given JSON Pointer (e.g. "/orders/17/price") inside a value,
+/// invalid if it does not exist. See PathQuery.
+Value query (const Value & root, const char * pointer);
+
+/// Returns the value at a given JSON Pointer inside JSON code, see PathQuery
+Value query (const char * data, int length, const char * pointer);
+
 /// Parses a JSON object and returns it in a json::Value
 /// Note: it must be an object!
 Value parse (const char * data, std::string & command, int length = -1);
 
 /// Parses a JSON string and returns it in a json::Value
 /// Note : it can be an arbitrary json code
-Value parse (const char * data, int length = -1);
+/// @param parseFlags see ParseFlags
+Value parse (const char * data, int length = -1, int parseFlags = 0);
 
 
 ///@endcond DEV
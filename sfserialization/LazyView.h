@@ -0,0 +1,64 @@
+#pragma once
+#include "Deserialization.h"
+#include <algorithm>
+
+namespace sf {
+
+/**
+ * Decodes members of a reflected type only when they are accessed.
+ *
+ * Parsing the JSON object only scans the sub values, so reading a few members
+ * out of a big message is much cheaper than deserializing it completely.
+ * Decoded members are cached. The type needs a memberName method, which is
+ * generated by sfautoreflect (SF_AUTOREFLECT_SD).
+ *
+ @verbatim
+	sf::LazyView<Envelope> view (json);
+	if (view.get (&Envelope::type) == "Ping") { ... }
+ @endverbatim
+ */
+template <class T> class LazyView {
+public:
+	/// Initializes with JSON code (it will be copied)
+	LazyView (const std::string & json) : mDeserialization (json), mFailed (false) {}
+
+	/// Initializes with a ready parsed object; note it wont make a copy
+	/// so keep the data available
+	LazyView (const json::Object & o) : mDeserialization (o), mFailed (false) {}
+
+	/// JSON code could not be parsed
+	bool error () const { return mDeserialization.error(); }
+
+	/// A member could not be decoded (it is left at its default value)
+	bool failed () const { return mFailed; }
+
+	/// Returns a member, decodes it on first access
+	template <class M, class C> const M & get (M C::* member) const {
+		M & m = mValue.*member;
+		const void * p = &m;
+		if (std::find (mDecoded.begin(), mDecoded.end(), p) == mDecoded.end()) {
+			const char * name = mValue.memberName (p);
+			if (!name || !mDeserialization (name, m)) mFailed = true;
+			mDecoded.push_back (p);
+		}
+		return m;
+	}
+
+	/// Decodes the whole object
+	/// @return true on success
+	bool fetch (T & dst) const {
+		return !error() && dst.deserialize (mDeserialization);
+	}
+
+private:
+	// not copyable (the parsed object points into our text)
+	LazyView (const LazyView &);
+	LazyView & operator= (const LazyView &);
+
+	Deserialization mDeserialization;
+	mutable T mValue;							///< Holds the already decoded members
+	mutable std::vector<const void*> mDecoded;	///< Addresses of decoded members
+	mutable bool mFailed;
+};
+
+}
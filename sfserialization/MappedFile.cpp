@@ -0,0 +1,88 @@
+#include "MappedFile.h"
+#include <stdio.h>
+
+#ifndef WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace sf {
+
+MappedFile::MappedFile () : mData (0), mSize (0), mOpen (false), mMapped (false) {
+}
+
+MappedFile::~MappedFile () {
+	close ();
+}
+
+/// Reads a whole file into a string
+static bool readFile (const char * path, std::string & dst) {
+	FILE * f = fopen (path, "rb");
+	if (!f) return false;
+	char buffer [65536];
+	size_t read;
+	while ((read = fread (buffer, 1, sizeof (buffer), f)) > 0) {
+		dst.append (buffer, read);
+	}
+	bool suc = !ferror (f);
+	fclose (f);
+	return suc;
+}
+
+bool MappedFile::open (const char * path) {
+	close ();
+#ifndef WIN32
+	int fd = ::open (path, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat s;
+	if (fstat (fd, &s) != 0) {
+		::close (fd);
+		return false;
+	}
+	if (s.st_size == 0) {
+		// cannot map empty files
+		::close (fd);
+		mOpen = true;
+		return true;
+	}
+	void * p = mmap (0, (size_t) s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close (fd); // mapping stays valid
+	if (p != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+		madvise (p, (size_t) s.st_size, MADV_SEQUENTIAL);
+#endif
+		mData   = (const char*) p;
+		mSize   = (size_t) s.st_size;
+		mMapped = true;
+		mOpen   = true;
+		return true;
+	}
+	// not mappable (e.g. a pipe), fall through to reading
+#endif
+	if (!readFile (path, mBuffer)) {
+		mBuffer.clear ();
+		return false;
+	}
+	mData = mBuffer.data();
+	mSize = mBuffer.size();
+	mOpen = true;
+	return true;
+}
+
+void MappedFile::close () {
+#ifndef WIN32
+	if (mMapped) {
+		munmap ((void*) mData, mSize);
+	}
+#endif
+	mBuffer.clear ();
+	mData   = 0;
+	mSize   = 0;
+	mOpen   = false;
+	mMapped = false;
+}
+
+}
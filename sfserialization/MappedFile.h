@@ -0,0 +1,45 @@
+#pragma once
+#include "types.h"
+
+namespace sf {
+
+/**
+ * A read only view of a whole file, memory mapped if possible.
+ *
+ * The kernel gets a sequential access hint so that it reads ahead and can drop already parsed pages.
+ * Note: the data is not null terminated, always use size().
+ * On platforms without mmap support the file is read into memory.
+ */
+class MappedFile {
+public:
+	MappedFile ();
+	~MappedFile ();
+
+	/// Opens (maps) the file; returns false if it could not be opened
+	bool open (const char * path);
+
+	/// Unmaps the file (also done by the destructor)
+	void close ();
+
+	/// File is opened
+	bool isOpen () const { return mOpen; }
+
+	/// Begin of the data (0 if not opened or empty)
+	const char * data () const { return mData; }
+
+	/// Size of the data in bytes
+	size_t size () const { return mSize; }
+
+private:
+	// not copyable
+	MappedFile (const MappedFile &);
+	MappedFile & operator= (const MappedFile &);
+
+	const char * mData;
+	size_t       mSize;
+	bool         mOpen;
+	bool         mMapped;		///< Data was mapped (otherwise it is in mBuffer)
+	std::string  mBuffer;		///< Fallback if mapping is not possible
+};
+
+}
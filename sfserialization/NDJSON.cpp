@@ -0,0 +1,77 @@
+#include "NDJSON.h"
+#include <boost/bind.hpp>
+
+namespace sf {
+
+NDJSONReader::NDJSONReader (const char * data, size_t length) : mData (data), mLength (length), mPosition (0), mLineNumber (0), mError (false) {
+}
+
+NDJSONReader::NDJSONReader (const std::string & data) : mData (data.c_str()), mLength (data.length()), mPosition (0), mLineNumber (0), mError (false) {
+}
+
+bool NDJSONReader::nextLine (const char ** begin, int * length) {
+	while (mPosition < mLength) {
+		const char * start = mData + mPosition;
+		size_t left = mLength - mPosition;
+		// memchr is vectorized in common C libraries
+		const char * end = (const char*) memchr (start, '\n', left);
+		if (!end) end = start + left;
+		mPosition = (end - mData) + (end < mData + mLength ? 1 : 0);
+		mLineNumber++;
+		const char * lineEnd = end;
+		if (lineEnd > start && lineEnd[-1] == '\r') lineEnd--;
+		const char * p = start;
+		while (p < lineEnd && (*p == ' ' || *p == '\t')) p++;
+		if (p == lineEnd) continue; // empty line
+		*begin  = p; // the parser doesn't accept leading whitespace
+		*length = (int) (lineEnd - p);
+		return true;
+	}
+	return false;
+}
+
+bool NDJSONReader::next (json::Value & value) {
+	mError = false;
+	const char * begin;
+	int length;
+	if (!nextLine (&begin, &length)) return false;
+	value = json::parse (begin, length);
+	if (!value.valid()) {
+		mError = true;
+		return false;
+	}
+	return true;
+}
+
+/// A line of a batch
+struct NDJSONLine {
+	const char * begin;
+	int length;
+};
+
+/// Parses and handles a batch of lines (executed in the pool)
+static void handleBatch (const std::vector<NDJSONLine> & lines, const NDJSONReader::RecordHandler & handler) {
+	for (std::vector<NDJSONLine>::const_iterator i = lines.begin(); i != lines.end(); i++) {
+		json::Value v = json::parse (i->begin, i->length);
+		handler (v);
+	}
+}
+
+void NDJSONReader::dispatch (ThreadPool & pool, const RecordHandler & handler, int batchSize) {
+	if (batchSize < 1) batchSize = 1;
+	TaskGroup group (pool);
+	std::vector<NDJSONLine> batch;
+	batch.reserve (batchSize);
+	NDJSONLine line;
+	while (nextLine (&line.begin, &line.length)) {
+		batch.push_back (line);
+		if ((int) batch.size() == batchSize) {
+			group.add (boost::bind (&handleBatch, batch, handler));
+			batch.clear ();
+		}
+	}
+	if (!batch.empty()) group.add (boost::bind (&handleBatch, batch, handler));
+	group.wait ();
+}
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "Serialization.h"
+#include "Deserialization.h"
+#include "ThreadPool.h"
+
+/**
+ * @file
+ * Newline delimited JSON (one JSON value per line), as used for logs and replay files.
+ */
+
+namespace sf {
+
+/**
+ * Reads newline delimited JSON.
+ *
+ * The reader does not copy the data (nor the lines), keep it available while reading.
+ * Empty lines (and a trailing '\r') are skipped.
+ *
+ @verbatim
+	NDJSONReader reader (data);
+	MyRecord record;
+	while (reader.next (record)) {
+		...
+	}
+	if (reader.error()) { ... }
+ @endverbatim
+ */
+class NDJSONReader {
+public:
+	/// Handler for dispatch, called with each record
+	typedef boost::function<void (const json::Value &)> RecordHandler;
+
+	NDJSONReader (const char * data, size_t length);
+	NDJSONReader (const std::string & data);
+
+	/// Fetches the next non empty line (without line ending)
+	/// @return false at the end of the data
+	bool nextLine (const char ** begin, int * length);
+
+	/// Parses the next record
+	/// @return false at the end of the data or if the record could not be parsed (see error())
+	bool next (json::Value & value);
+
+	/// Parses and deserializes the next record
+	/// @return false at the end of the data or if the record could not be parsed (see error())
+	template <class T> bool next (T & dst) {
+		json::Value v;
+		if (!next (v)) return false;
+		if (!deserialize (v, dst)) {
+			mError = true;
+			return false;
+		}
+		return true;
+	}
+
+	/// The last record could not be parsed (next() will continue with the following one)
+	bool error () const { return mError; }
+
+	/// Reading position (in bytes)
+	size_t position () const { return mPosition; }
+
+	/// Line number of the last returned record (starting with 1)
+	size_t lineNumber () const { return mLineNumber; }
+
+	/**
+	 * Parses all (remaining) records in batches of batchSize records on the thread pool.
+	 * Returns when all records are handled. The handler is called concurrently and gets
+	 * invalid values for lines which could not be parsed; the record order is not kept.
+	 */
+	void dispatch (ThreadPool & pool, const RecordHandler & handler, int batchSize = 1024);
+
+private:
+	const char * mData;
+	size_t       mLength;
+	size_t       mPosition;
+	size_t       mLineNumber;
+	bool         mError;
+};
+
+/**
+ * Writes records as newline delimited JSON into one buffer.
+ */
+class NDJSONWriter {
+public:
+	/// Appends to target, flags are SerializationFlags (INDENT is ignored)
+	NDJSONWriter (std::string & target, int flags = 0) : mTarget (target), mFlags (flags & ~INDENT) {}
+
+	/// Appends one record
+	template <class T> void write (const T & obj) {
+		{
+			Serialization s (mTarget, mFlags & COMPRESS, false, mFlags & COMPACT);
+			serialize (s, obj); // koenig lookup
+		}
+		mTarget.push_back ('\n');
+	}
+
+private:
+	std::string & mTarget;
+	int mFlags;
+};
+
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include "Serialization.h"
+#include "Deserialization.h"
+#include "ThreadPool.h"
+#include <boost/bind.hpp>
+#include <algorithm>
+
+/**
+ * @file
+ * Parallel (de)serialization of big top level arrays, using a sf::ThreadPool.
+ *
+ * The results are the same as with the serial functions, which are still faster for small data.
+ */
+
+namespace sf {
+
+///@cond DEV
+
+/// Deserializes elements [begin, end) of an array in place
+/// Sets failed to the first element which could not be deserialized
+template <class T> void deserializeRange (const json::Array * array, std::vector<T> * dst, int begin, int end, int * failed, bool updateInPlace) {
+	DeserializationScope scope (0, updateInPlace); // pools are not thread safe
+	for (int i = begin; i < end; i++) {
+		if (!deserialize (array->get (i), (*dst)[i])) {
+			*failed = i;
+			return;
+		}
+	}
+}
+
+/// Serializes elements [begin, end) of a vector into target, comma separated
+template <class T> void serializeRange (const std::vector<T> * src, int begin, int end, std::string * target, int flags) {
+	Serialization s (*target, flags & COMPRESS, flags & INDENT, flags & COMPACT);
+	for (int i = begin; i < end; i++) {
+		serialize (s, (*src)[i]);
+	}
+}
+
+/// Number of elements handled by one task
+inline int parallelChunkSize (int count, const ThreadPool & pool) {
+	int chunk = count / (pool.threadCount() * 4); // some more chunks than threads, for load balancing
+	return chunk < 64 ? 64 : chunk;
+}
+
+///@endcond DEV
+
+/// Converts a big vector to JSON, the elements are serialized concurrently into
+/// separate buffers which are joined afterwards. The result is the same as with toJSONEx.
+/// flags - flags ORED of SerializationFlags
+template <class T> std::string toJSONParallel (const std::vector<T> & obj, ThreadPool & pool, int flags = 0) {
+	int count = (int) obj.size();
+	int chunk = parallelChunkSize (count, pool);
+	int chunks = (count + chunk - 1) / chunk;
+	std::vector<std::string> parts (chunks);
+	{
+		TaskGroup group (pool);
+		for (int c = 0; c < chunks; c++) {
+			int begin = c * chunk;
+			int end   = std::min (begin + chunk, count);
+			group.add (boost::bind (&serializeRange<T>, &obj, begin, end, &parts[c], flags));
+		}
+		group.wait ();
+	}
+	size_t size = 2;
+	for (int c = 0; c < chunks; c++) size += parts[c].size() + 2;
+	std::string target;
+	target.reserve (size);
+	target.push_back ('[');
+	for (int c = 0; c < chunks; c++) {
+		if (c > 0) target.append (", ");
+		target.append (parts[c]);
+	}
+	target.push_back (']');
+	return target;
+}
+
+/// Reads a std::vector out of a json Array, the elements are deserialized concurrently.
+/// On an error the vector contains the elements before the failing one (like the serial deserialize).
+/// The update mode of the current DeserializationContext is respected, a StringPool is not
+/// (it is not thread safe), InternedString members are not pooled.
+template <class T> bool deserializeParallel (const json::Value & v, std::vector<T> & vector, ThreadPool & pool){
+	json::Array a;
+	if (!v.fetch(a)) return false;
+	int count = a.count();
+	bool updateInPlace = DeserializationContext::current().updateInPlace;
+	if (!updateInPlace) vector.clear ();
+	vector.resize (count);
+	int chunk = parallelChunkSize (count, pool);
+	int chunks = (count + chunk - 1) / chunk;
+	std::vector<int> failed (chunks, count);
+	{
+		TaskGroup group (pool);
+		for (int c = 0; c < chunks; c++) {
+			int begin = c * chunk;
+			int end   = std::min (begin + chunk, count);
+			group.add (boost::bind (&deserializeRange<T>, &a, &vector, begin, end, &failed[c], updateInPlace));
+		}
+		group.wait ();
+	}
+	for (int c = 0; c < chunks; c++) {
+		if (failed[c] < count) {
+			vector.resize (failed[c]);
+			return false;
+		}
+	}
+	return true;
+}
+
+/// Reads a std::vector<bool> serially, its elements are bits and cannot be written concurrently
+inline bool deserializeParallel (const json::Value & v, std::vector<bool> & vector, ThreadPool & pool){
+	return deserialize (v, vector);
+}
+
+/// Deserializes a big top level JSON array concurrently, see deserializeParallel
+/// @return true on success
+template <class T> bool fromJSONParallel (const std::string & txt, std::vector<T> & dst, ThreadPool & pool){
+	json::Value v = json::parse(txt.c_str(), txt.length());
+	return deserializeParallel (v, dst, pool);
+}
+
+/// Deserializes a big top level JSON array concurrently, see deserializeParallel
+/// @return true on success
+template <class T> bool fromJSONParallel (const ByteArrayBase & data, std::vector<T> & dst, ThreadPool & pool){
+	json::Value v = json::parse(&data.front(), data.size());
+	return deserializeParallel (v, dst, pool);
+}
+
+}
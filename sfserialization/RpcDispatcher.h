@@ -0,0 +1,233 @@
+#pragma once
+#include "Deserialization.h"
+#include "ThreadPool.h"
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <deque>
+#include <string.h>
+
+namespace sf {
+
+/// Executors of sf::RpcDispatcher
+struct RpcDispatcherBase {
+	enum Executor { Inline, Dedicated, Pool };
+};
+
+/**
+ * Routes RPC frames to an object with generated RPC methods (SF_AUTOREFLECT_RPC), each
+ * command is executed by a configurable executor:
+ * - Inline    in the thread calling dispatch (the default); frames queued behind frames of
+ *             other executors are executed by the next call of dispatch, poll or wait
+ * - Dedicated in one thread owned by the dispatcher (all dedicated commands share it)
+ * - Pool      in a shared sf::ThreadPool
+ *
+ * Frames of the same sender are handled in the order they were dispatched, even if their
+ * commands use different executors (a frame starts after the previous one of its sender
+ * is done). Frames of different senders run concurrently, so the handlers of
+ * Dedicated and Pool commands must be thread safe.
+ *
+ * Configure the executors before dispatching frames.
+ *
+ * @verbatim
+	sf::ThreadPool pool;
+	sf::RpcDispatcher<MyService> dispatcher (service, &pool);
+	dispatcher.setExecutor ("slowCommand", sf::RpcDispatcherBase::Pool);
+	dispatcher.dispatch (sender, cmd, header, data);
+ * @endverbatim
+ */
+template <class C> class RpcDispatcher : public RpcDispatcherBase {
+public:
+	typedef typename C::RpcCall::Sender  Sender;
+	typedef typename C::RpcCall::Command Command;
+	typedef typename C::RpcCall::Payload Payload;
+
+	/// Dispatches to target, pool is needed for commands using the Pool executor
+	RpcDispatcher (C & target, ThreadPool * pool = 0) : mTarget (target), mPool (pool), mPending (0), mHandled (0), mFailed (0) {
+		for (const char ** cmd = target.commands(); *cmd; cmd++) mExecutors.push_back (Inline);
+	}
+
+	/// Waits for all dispatched frames
+	~RpcDispatcher () {
+		wait ();
+	}
+
+	/// Sets the executor of one command
+	/// @return false if the command is not known or there is no pool for the Pool executor
+	bool setExecutor (const char * cmd, Executor executor) {
+		int index = C::rpcCommandIndex (cmd, strlen (cmd));
+		if (index < 0 || !prepare (executor)) return false;
+		mExecutors[index] = executor;
+		return true;
+	}
+
+	/// Sets the executor of all commands
+	bool setExecutor (Executor executor) {
+		if (!prepare (executor)) return false;
+		mExecutors.assign (mExecutors.size(), executor);
+		return true;
+	}
+
+	/// Dispatches a frame, the header is JSON code (without the command name)
+	/// @return false if the command is unknown or (if executed immediately) the handler failed
+	bool dispatch (const Sender & sender, const Command & cmd, const std::string & header, const Payload & data = Payload()) {
+		poll ();
+		int index = C::rpcCommandIndex (cmd.c_str(), cmd.size());
+		if (index < 0) return false;
+		Frame * frame = new Frame (sender, cmd, header, data, mExecutors[index]);
+		bool idle;
+		{
+			boost::mutex::scoped_lock lock (mMutex);
+			mPending++;
+			std::deque<Frame*> & strand = mStrands[sender];
+			idle = strand.empty();
+			strand.push_back (frame);
+		}
+		if (!idle) return true; // started after the previous frames of the sender
+		if (frame->executor == Inline) {
+			bool result;
+			start (execute (frame, &result));
+			return result;
+		}
+		start (frame);
+		return true;
+	}
+
+	/// Executes inline frames whose previous frame (of another executor) is done
+	void poll () {
+		for (;;) {
+			Frame * frame;
+			{
+				boost::mutex::scoped_lock lock (mMutex);
+				if (mReady.empty()) return;
+				frame = mReady.front();
+				mReady.pop_front ();
+			}
+			start (frame);
+		}
+	}
+
+	/// Waits until all dispatched frames are handled, executes ready inline frames meanwhile
+	/// @note Do not call from inside a handler
+	void wait () {
+		boost::mutex::scoped_lock lock (mMutex);
+		while (mPending > 0) {
+			if (mReady.empty()) {
+				mDone.wait (lock);
+				continue;
+			}
+			Frame * frame = mReady.front();
+			mReady.pop_front ();
+			lock.unlock ();
+			start (frame);
+			lock.lock ();
+		}
+	}
+
+	/// Number of handled frames
+	int handled () const {
+		boost::mutex::scoped_lock lock (mMutex);
+		return mHandled;
+	}
+
+	/// Number of handled frames which failed (wrong parameters, rejected by the handler or the handler threw)
+	int failed () const {
+		boost::mutex::scoped_lock lock (mMutex);
+		return mFailed;
+	}
+
+private:
+	// not copyable
+	RpcDispatcher (const RpcDispatcher &);
+	RpcDispatcher & operator= (const RpcDispatcher &);
+
+	struct Frame {
+		Frame (const Sender & sender, const Command & cmd, const std::string & header, const Payload & data, Executor executor) :
+			sender (sender), cmd (cmd), header (header), data (data), executor (executor) {}
+		Sender      sender;
+		Command     cmd;
+		std::string header;
+		Payload     data;
+		Executor    executor;
+	};
+
+	/// Creates the resources of an executor
+	bool prepare (Executor executor) {
+		if (executor == Pool && !mPool) return false;
+		if (executor == Dedicated && !mDedicated) mDedicated.reset (new ThreadPool (1));
+		return true;
+	}
+
+	/// Starts a frame (which is the first of its sender) on its executor, inline frames
+	/// are executed in the current thread (which must be a dispatching one).
+	void start (Frame * frame) {
+		while (frame && frame->executor == Inline) {
+			frame = execute (frame);
+		}
+		if (frame) submit (frame);
+	}
+
+	/// Hands a Dedicated or Pool frame to its executor
+	void submit (Frame * frame) {
+		ThreadPool & executor = frame->executor == Pool ? *mPool : *mDedicated;
+		executor.add (boost::bind (&RpcDispatcher::run, this, frame));
+	}
+
+	/// Task of the Dedicated and Pool executors, inline successors are handed back
+	/// to the dispatching threads
+	void run (Frame * frame) {
+		Frame * next = execute (frame);
+		if (!next) return;
+		if (next->executor != Inline) {
+			submit (next);
+			return;
+		}
+		boost::mutex::scoped_lock lock (mMutex);
+		mReady.push_back (next);
+		mDone.notify_all ();
+	}
+
+	/// Executes a frame and returns the next one of the same sender (if any)
+	/// Exceptions of the handler count as failure, the strand continues.
+	Frame * execute (Frame * frame, bool * result = 0) {
+		bool suc;
+		try {
+			Deserialization header (frame->header);
+			suc = mTarget.handleRpc (frame->sender, frame->cmd, header, frame->data);
+		} catch (...) {
+			suc = false;
+		}
+		if (result) *result = suc;
+		Frame * next = 0;
+		{
+			boost::mutex::scoped_lock lock (mMutex);
+			mHandled++;
+			if (!suc) mFailed++;
+			typename StrandMap::iterator i = mStrands.find (frame->sender);
+			i->second.pop_front ();
+			if (i->second.empty()) mStrands.erase (i);
+			else next = i->second.front();
+			mPending--;
+			if (mPending == 0) mDone.notify_all ();
+		}
+		delete frame;
+		return next;
+	}
+
+	/// Frames of each sender, the first one is currently running
+	typedef std::map<Sender, std::deque<Frame*> > StrandMap;
+
+	C &                           mTarget;
+	ThreadPool *                  mPool;
+	boost::scoped_ptr<ThreadPool> mDedicated;	///< Thread of the Dedicated executor (created on demand)
+	std::vector<Executor>         mExecutors;	///< Executor for each command index
+
+	mutable boost::mutex          mMutex;
+	boost::condition_variable     mDone;		///< No more pending frames or a new ready inline frame
+	StrandMap                     mStrands;
+	std::deque<Frame*>            mReady;		///< Inline frames waiting for a dispatching thread
+	int                           mPending;		///< Frames dispatched but not handled
+	int                           mHandled;
+	int                           mFailed;
+};
+
+}
@@ -120,6 +120,12 @@ void Serialization::insertStringValue (const char * stringValue) {
 	mNeedComma = true;
 }
 
+void Serialization::insertStringValue (const char * stringValue, size_t length) {
+	if (mNeedComma) cacheAppend (", ");
+	addString (stringValue, length, true);
+	mNeedComma = true;
+}
+
 
 void Serialization::cacheAppend (const char * s) { 
 	const char * c = s;
@@ -138,8 +144,12 @@ void Serialization::cacheAppend (const char c){
 
 
 void Serialization::addString (const char * s, bool quoted){
+	addString (s, strlen (s), quoted);
+}
+
+void Serialization::addString (const char * s, size_t length, bool quoted){
 	if (quoted) cacheAppend ('"');
-	for (const char *i = s; *i != 0; i++){
+	for (const char *i = s; i != s + length; i++){
 		switch (*i){
 			case '\\': cacheAppend ("\\\\"); break;
 			case '"': cacheAppend ("\\\""); break;
@@ -200,6 +210,14 @@ void serialize (Serialization & s, const char* data) {
 	s.insertStringValue (data);
 }
 
+void serialize (Serialization & s, const StringView & data) {
+	s.insertStringValue (data.data(), data.size());
+}
+
+void serialize (Serialization & s, const InternedString & data) {
+	s.insertStringValue (data.c_str(), data.size());
+}
+
 
 
 }
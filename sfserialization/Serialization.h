@@ -1,6 +1,7 @@
 #pragma once
 #include "types.h"
 #include "isdefault.h"
+#include "StringPool.h"
 #include <boost/utility/enable_if.hpp>
 #include <boost/type_traits/is_enum.hpp>
 #include <boost/lexical_cast.hpp>
@@ -69,6 +70,8 @@ public:
 	void insertValue       (const char * value);
 	/// Insert a string value (does also \n-Handling etc.)
 	void insertStringValue (const char * stringValue);
+	/// Insert a string value with given length (need not to be 0-terminated)
+	void insertStringValue (const char * stringValue, size_t length);
 	
 	///@}
 
@@ -95,6 +98,8 @@ private:
 	
 	/// Adds a string to the cache with escape symbols and begin/end " .. " (if quoted == true)
 	void addString (const char * c, bool quoted = true);
+	/// Adds a string with given length, see above
+	void addString (const char * c, size_t length, bool quoted);
 	std::string & mTarget;
 	bool mNeedComma;		///< Next one needs a comma
 	
@@ -132,6 +137,7 @@ enum SerializationFlags {
 	COMPRESS = 0x1,		///< Compress (omits values which are default values)
 	INDENT   = 0x4,		///< Indent the output (for better human readability)
 	COMPACT  = 0x8,		///< Skip quotes on keys (shorter, but illegal JSON)
+	FIELD_IDS = 0x10,	///< Binary format only: write numeric field ids instead of key names
 };
 
 /// Converts a given object to JSON, you can control wether to compress, to start with name (command mode) or to indent.
@@ -158,6 +164,8 @@ void serialize (Serialization & s, double data);
 void serialize (Serialization & s, bool data);
 void serialize (Serialization & s, const std::string& data);
 void serialize (Serialization & s, const char* data);
+void serialize (Serialization & s, const StringView & data);
+void serialize (Serialization & s, const InternedString & data);
 
 /// Serialize method for sets
 template <class T> static void serialize (sf::Serialization & s, const std::set<T> & container) {
@@ -0,0 +1,19 @@
+#include "StringPool.h"
+
+namespace sf {
+
+const std::string & InternedString::emptyString () {
+	static std::string empty;
+	return empty;
+}
+
+InternedString StringPool::intern (const char * data, size_t length) {
+	if (length == 0) return InternedString ();
+	StringMap::const_iterator i = mStrings.find (StringView (data, length));
+	if (i != mStrings.end()) return InternedString (i->second);
+	boost::shared_ptr<const std::string> s (new std::string (data, length));
+	mStrings[StringView (*s)] = s;
+	return InternedString (s);
+}
+
+}
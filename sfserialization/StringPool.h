@@ -0,0 +1,84 @@
+#pragma once
+#include "types.h"
+#include "StringView.h"
+#include <boost/shared_ptr.hpp>
+
+namespace sf {
+
+/**
+ * An immutable string, which is shared between all copies and all equal strings
+ * resolved by the same sf::StringPool.
+ *
+ * Use it for members with a small vocabulary of values (status codes, symbols, host names),
+ * deserializing them with a pool does only allocate for the first occurrence of each value.
+ */
+class InternedString {
+public:
+	InternedString () {}
+	/// Creates a (not pooled) string
+	explicit InternedString (const std::string & s) : mString (new std::string (s)) {}
+
+	/// Returns the string
+	const std::string & str () const { return mString ? *mString : emptyString(); }
+	/// Begin of the string (0-terminated)
+	const char * c_str () const { return str().c_str(); }
+	/// Length of the string
+	size_t size () const { return mString ? mString->size() : 0; }
+	/// String is empty
+	bool empty () const { return size() == 0; }
+	/// Used by sf::Serialization in compress mode
+	bool isDefault () const { return empty(); }
+	/// Returns a view on the string
+	StringView view () const { return StringView (str()); }
+
+	bool operator== (const InternedString & other) const {
+		return mString == other.mString || str() == other.str();
+	}
+	bool operator!= (const InternedString & other) const { return !(*this == other); }
+	bool operator< (const InternedString & other) const { return str() < other.str(); }
+	bool operator== (const std::string & other) const { return str() == other; }
+	bool operator!= (const std::string & other) const { return str() != other; }
+
+private:
+	friend class StringPool;
+	explicit InternedString (const boost::shared_ptr<const std::string> & s) : mString (s) {}
+	static const std::string & emptyString ();
+
+	boost::shared_ptr<const std::string> mString;	///< 0 for the empty string
+};
+
+/**
+ * Deduplicates strings, equal strings are resolved to the same shared storage.
+ *
+ * Pass it to fromJSON (or activate it with a DeserializationScope) and all InternedString members
+ * get resolved by it. Strings stay alive as long as they are used, even if the pool is destroyed.
+ *
+ * @note A pool must not be used by multiple threads at the same time.
+ */
+class StringPool {
+public:
+	StringPool () {}
+
+	/// Returns the shared copy of a string, adds it if not existing yet
+	InternedString intern (const char * data, size_t length);
+
+	/// Returns the shared copy of a string, adds it if not existing yet
+	InternedString intern (const std::string & s) { return intern (s.c_str(), s.length()); }
+
+	/// Number of different strings
+	size_t size () const { return mStrings.size(); }
+
+	/// Forgets all strings (they stay available for their users)
+	void clear () { mStrings.clear(); }
+
+private:
+	// not copyable
+	StringPool (const StringPool &);
+	StringPool & operator= (const StringPool &);
+
+	/// Keys point into the strings stored as value
+	typedef std::map<StringView, boost::shared_ptr<const std::string> > StringMap;
+	StringMap mStrings;
+};
+
+}
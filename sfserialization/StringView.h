@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string.h>
+#include <string>
+#include <ostream>
+
+/**
+ * @file
+ * A non owning reference to a piece of text.
+ *
+ * Like the json parser it is only dependent on standard C++.
+ */
+
+namespace sf {
+
+/**
+ * Pointer and length of a string, which is owned by someone else (e.g. the JSON code
+ * which was parsed). It is cheap to copy and never allocates.
+ *
+ * When deserializing into a StringView it points into the JSON code given to fromJSON,
+ * so the code must be kept available as long as the view is used. Strings with escape
+ * sequences cannot be represented without decoding, deserializing them fails.
+ */
+class StringView {
+public:
+	StringView () : mData (""), mSize (0) {}
+	StringView (const char * data, size_t size) : mData (data), mSize (size) {}
+	StringView (const char * data) : mData (data), mSize (strlen (data)) {}
+	StringView (const std::string & s) : mData (s.c_str()), mSize (s.length()) {}
+
+	/// Begin of the string (not 0-terminated)
+	const char * data () const { return mData; }
+	/// Length of the string
+	size_t size () const { return mSize; }
+	/// Length of the string
+	size_t length () const { return mSize; }
+	/// String is empty
+	bool empty () const { return mSize == 0; }
+	/// Accesses a character
+	char operator[] (size_t i) const { return mData[i]; }
+
+	/// Returns an owning copy
+	std::string str () const { return std::string (mData, mSize); }
+
+	/// Lexicographical comparison (like std::string::compare)
+	int compare (const StringView & other) const {
+		size_t l = mSize < other.mSize ? mSize : other.mSize;
+		int c = l ? memcmp (mData, other.mData, l) : 0;
+		if (c != 0) return c;
+		if (mSize == other.mSize) return 0;
+		return mSize < other.mSize ? -1 : 1;
+	}
+
+	bool operator== (const StringView & other) const {
+		return mSize == other.mSize && (mSize == 0 || memcmp (mData, other.mData, mSize) == 0);
+	}
+	bool operator!= (const StringView & other) const { return !(*this == other); }
+	bool operator< (const StringView & other) const { return compare (other) < 0; }
+private:
+	const char * mData;
+	size_t mSize;
+};
+
+}
+
+inline std::ostream & operator<< (std::ostream & stream, const sf::StringView & view) {
+	stream.write (view.data(), view.size());
+	return stream;
+}
@@ -0,0 +1,66 @@
+#include "ThreadPool.h"
+#include <boost/bind.hpp>
+
+namespace sf {
+
+ThreadPool::ThreadPool (int threads) : mStop (false) {
+	if (threads <= 0) threads = (int) boost::thread::hardware_concurrency ();
+	if (threads <= 0) threads = 1;
+	mThreadCount = threads;
+	for (int i = 0; i < threads; i++) {
+		mThreads.create_thread (boost::bind (&ThreadPool::run, this));
+	}
+}
+
+ThreadPool::~ThreadPool () {
+	{
+		boost::mutex::scoped_lock lock (mMutex);
+		mStop = true;
+	}
+	mCondition.notify_all ();
+	mThreads.join_all ();
+}
+
+void ThreadPool::add (const Task & task) {
+	{
+		boost::mutex::scoped_lock lock (mMutex);
+		mTasks.push_back (task);
+	}
+	mCondition.notify_one ();
+}
+
+void ThreadPool::run () {
+	for (;;) {
+		Task task;
+		{
+			boost::mutex::scoped_lock lock (mMutex);
+			while (mTasks.empty() && !mStop) mCondition.wait (lock);
+			if (mTasks.empty()) return; // stopped and nothing left
+			task = mTasks.front ();
+			mTasks.pop_front ();
+		}
+		task ();
+	}
+}
+
+void TaskGroup::add (const ThreadPool::Task & task) {
+	{
+		boost::mutex::scoped_lock lock (mMutex);
+		mPending++;
+	}
+	mPool.add (boost::bind (&TaskGroup::execute, this, task));
+}
+
+void TaskGroup::wait () {
+	boost::mutex::scoped_lock lock (mMutex);
+	while (mPending > 0) mDone.wait (lock);
+}
+
+void TaskGroup::execute (const ThreadPool::Task & task) {
+	task ();
+	boost::mutex::scoped_lock lock (mMutex);
+	mPending--;
+	if (mPending == 0) mDone.notify_all ();
+}
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "types.h"
+#include <deque>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+namespace sf {
+
+/**
+ * A simple fixed size pool of worker threads executing tasks in FIFO order.
+ *
+ * Used for the parallel (de)serialization functions; one pool can be shared
+ * between them. Tasks are grouped and awaited with sf::TaskGroup.
+ */
+class ThreadPool {
+public:
+	typedef boost::function<void ()> Task;
+
+	/// Starts the pool with given number of threads (0 = number of cores)
+	explicit ThreadPool (int threads = 0);
+
+	/// Waits for all queued tasks and stops the threads
+	~ThreadPool ();
+
+	/// Adds a task for execution
+	void add (const Task & task);
+
+	/// Number of worker threads
+	int threadCount () const { return mThreadCount; }
+
+private:
+	// not copyable
+	ThreadPool (const ThreadPool &);
+	ThreadPool & operator= (const ThreadPool &);
+
+	/// Main loop of worker threads
+	void run ();
+
+	boost::mutex              mMutex;
+	boost::condition_variable mCondition;	///< New task or stop
+	std::deque<Task>          mTasks;
+	bool                      mStop;
+	int                       mThreadCount;
+	boost::thread_group       mThreads;
+};
+
+/**
+ * A group of tasks added to a ThreadPool, which can be waited for.
+ *
+ * @note Do not wait from inside a pool thread, it may deadlock if all threads are waiting.
+ */
+class TaskGroup {
+public:
+	TaskGroup (ThreadPool & pool) : mPool (pool), mPending (0) {}
+
+	/// Waits for all pending tasks
+	~TaskGroup () { wait (); }
+
+	/// Adds a task to the pool
+	void add (const ThreadPool::Task & task);
+
+	/// Waits until all tasks of this group are done
+	void wait ();
+
+private:
+	// not copyable
+	TaskGroup (const TaskGroup &);
+	TaskGroup & operator= (const TaskGroup &);
+
+	/// Executes a task and marks it as done
+	void execute (const ThreadPool::Task & task);
+
+	ThreadPool &              mPool;
+	boost::mutex              mMutex;
+	boost::condition_variable mDone;
+	int                       mPending;		///< Tasks added but not finished
+};
+
+}
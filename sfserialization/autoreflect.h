@@ -1,20 +1,37 @@
 #ifndef SF_AUTOREFLECT_HEADER_GUARD
 #define SF_AUTOREFLECT_HEADER_GUARD
 
+#include <stddef.h>
+#ifdef WIN32
+#include "winsupport.h"
+#else
+#include <stdint.h>
+#endif
+
 namespace sf {
 	class Serialization;
 	class Deserialization;
+	class BinarySerialization;
+	class BinaryDeserialization;
 }
 
-// serialize and isDefault() method
+// serialize (JSON and binary) and isDefault() method
 #define SF_AUTOREFLECT_SERIAL \
 	void serialize (sf::Serialization & s) const; \
+	void serialize (sf::BinarySerialization & s) const; \
 	bool isDefault () const;
 
-// serialize, isDefault and deserialize method
+// serialize, isDefault and deserialize (JSON and binary) method
+// memberName returns the key name of a member (given by address), used by sf::LazyView
 #define SF_AUTOREFLECT_SERIAL_DESERIAL \
 	SF_AUTOREFLECT_SERIAL; \
-	bool deserialize (const sf::Deserialization & s);
+	bool deserialize (const sf::Deserialization & s); \
+	bool deserialize (const sf::BinaryDeserialization & s); \
+	const char * memberName (const void * member) const;
+
+/// Sets the numeric field id of a member, used by the binary format (FIELD_IDS)
+/// Without it members are numbered in declaration order, starting with 1.
+#define SF_AUTOREFLECT_FIELDID(MEMBER, ID)
 
 /// Get cmd name generates a command name for a type
 #define SF_AUTOREFLECT_GETCMDNAME \
@@ -29,19 +46,57 @@ namespace sf {
 	SF_AUTOREFLECT_SERIAL_DESERIAL \
 	SF_AUTOREFLECT_GETCMDNAME;
 
-// Enum toString and fromString method
+// Enum toString and fromString method (fromString also for not 0-terminated strings)
 #define SF_AUTOREFLECT_ENUM_TOFROMSTRING(X)\
 	const char * toString (X e);\
-	bool fromString (const char* s, X & e);
+	bool fromString (const char* s, X & e);\
+	bool fromString (const char* s, size_t length, X & e);
 
 // Abbreviation for SF_AUTOREFLECT_ENUM_TOFROMSTRING 
 #define SF_AUTOREFLECT_ENUM(X) \
 	SF_AUTOREFLECT_ENUM_TOFROMSTRING(X);
 
+// RPC dispatching methods, see RpcGenerator
+// The payload can be passed as ByteArray or as non owning ByteView (handlers taking
+// a ByteView get it without copying, handlers taking a ByteArray get a copy only if necessary).
+// handleRpcBatch handles the calls grouped by command (in order within one command) and
+// returns the number of successfully handled calls, results (if given) gets the result of each call.
 #define SF_AUTOREFLECT_RPC \
 	const char * name () const;\
 	const char ** commands () const; \
-	bool handleRpc (const sf::HostId &, const sf::String & cmdName, const sf::Deserialization & header, const sf::ByteArray & data = sf::ByteArray());
+	struct RpcCall {\
+		typedef sf::HostId Sender;\
+		typedef sf::String Command;\
+		typedef sf::ByteArray Payload;\
+		RpcCall (const sf::HostId & sender, const sf::String & cmd, const sf::Deserialization & header) :\
+			sender (&sender), cmd (&cmd), header (&header), array (0) {}\
+		RpcCall (const sf::HostId & sender, const sf::String & cmd, const sf::Deserialization & header, const sf::ByteArray & data) :\
+			sender (&sender), cmd (&cmd), header (&header), array (&data), data (data) {}\
+		RpcCall (const sf::HostId & sender, const sf::String & cmd, const sf::Deserialization & header, const sf::ByteView & data) :\
+			sender (&sender), cmd (&cmd), header (&header), array (0), data (data) {}\
+		const sf::HostId * sender;\
+		const sf::String * cmd;\
+		const sf::Deserialization * header;\
+		const sf::ByteArray * array; /* set if the payload is available as ByteArray */\
+		sf::ByteView data;\
+	};\
+	bool handleRpc (const RpcCall & call);\
+	bool handleRpc (const sf::HostId & sender, const sf::String & cmdName, const sf::Deserialization & header) {\
+		return handleRpc (RpcCall (sender, cmdName, header));\
+	}\
+	bool handleRpc (const sf::HostId & sender, const sf::String & cmdName, const sf::Deserialization & header, const sf::ByteArray & data) {\
+		return handleRpc (RpcCall (sender, cmdName, header, data));\
+	}\
+	bool handleRpc (const sf::HostId & sender, const sf::String & cmdName, const sf::Deserialization & header, const sf::ByteView & data) {\
+		return handleRpc (RpcCall (sender, cmdName, header, data));\
+	}\
+	int handleRpcBatch (const RpcCall * calls, size_t count, bool * results = 0);\
+	static int rpcCommandIndex (const char * cmd, size_t length);
+
+// Like SF_AUTOREFLECT_RPC, but the generated handleRpc reuses one parameter object per command
+// and thread (instead of creating one for each call), so that its containers keep their storage.
+#define SF_AUTOREFLECT_RPC_REUSE \
+	SF_AUTOREFLECT_RPC
 
 namespace sf {
 
@@ -55,6 +110,40 @@ inline HashValue hash(const unsigned char *str) {
 	return hash;
 }
 
+/**
+ * Handling of asynchronous results of RPC handlers (see RpcGenerator).
+ *
+ * An onRpc handler may return a future or a task like type R instead of void, after starting its work
+ * (e.g. by posting it to an executor). The generated handleRpc passes the result to handOff and returns
+ * immediately. There is no default: each asynchronous result type needs a specialization with
+ * a static handOff (R) method, which stores, awaits or detaches the result (keep care of types whose
+ * destructor blocks, like futures returned by std::async). Other return types (a typo or a synchronous
+ * result) do not compile, instead of being dropped silently.
+ *
+ * @verbatim
+	namespace sf {
+	template <> struct RpcAsyncTraits<MyTask> {
+		static void handOff (const MyTask & task) { task.detach (); }
+	};
+	}
+ * @endverbatim
+ */
+template <class R> struct RpcAsyncTraits;
+
+/// Seeded hash used by the generated (perfect hash) lookup tables, seed 0 is plain FNV-1a
+/// with a final mixing step (so that the lower bits are usable for modulo operations)
+inline uint32_t hashSeeded (const char * str, size_t length, uint32_t seed) {
+	uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+	for (size_t i = 0; i < length; i++) {
+		h ^= (unsigned char) str[i];
+		h *= 16777619u;
+	}
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	return h;
+}
+
 }
 
 #endif
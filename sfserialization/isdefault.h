@@ -4,6 +4,7 @@
 #include <boost/type_traits/is_enum.hpp>
 
 #include "types.h"
+#include "StringView.h"
 
 /**@file
 isDefault methods for different types. They are needed for Serialization
@@ -36,6 +37,10 @@ inline bool isDefault (const std::string & s) {
 	return s.empty();
 }
 
+inline bool isDefault (const StringView & s) {
+	return s.empty();
+}
+
 template <class T> static bool isDefault (const std::vector<T> & data){
 	return data.empty();
 }
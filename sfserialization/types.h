@@ -20,4 +20,29 @@ namespace sf {
 
 typedef std::vector<char> ByteArrayBase; ///< In libschnee sf::ByteArray derives from std::vector<char>
 
+/**
+ * Non owning reference to a block of bytes (e.g. a part of a receive buffer).
+ * Cheap to copy, the referenced data must stay alive as long as the view is used.
+ */
+class ByteView {
+public:
+	typedef const char * const_iterator;
+	ByteView () : mData (0), mSize (0) {}
+	ByteView (const char * data, size_t size) : mData (data), mSize (size) {}
+	ByteView (const ByteArrayBase & array) : mData (array.empty() ? 0 : &array[0]), mSize (array.size()) {}
+
+	/// Begin of the data (may be 0 if empty)
+	const char * data () const { return mData; }
+	/// Number of bytes
+	size_t size () const { return mSize; }
+	/// View is empty
+	bool empty () const { return mSize == 0; }
+	const char * begin () const { return mData; }
+	const char * end () const { return mData + mSize; }
+	char operator[] (size_t i) const { return mData[i]; }
+private:
+	const char * mData;
+	size_t mSize;
+};
+
 }
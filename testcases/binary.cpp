@@ -0,0 +1,160 @@
+#include "test.h"
+#include <sfserialization/BinarySerialization.h>
+#include <sfserialization/BinaryDeserialization.h>
+
+/*
+ * Tests the binary serializing / deserializing routines
+ */
+
+enum Color { Red, Green, Blue };
+
+const char * toString (Color c) {
+	const char * values [] = { "Red", "Green", "Blue" };
+	return values[(int) c];
+}
+
+bool fromString (const char * s, Color & c) {
+	if (strcmp (s, "Red") == 0)   { c = Red; return true; }
+	if (strcmp (s, "Green") == 0) { c = Green; return true; }
+	if (strcmp (s, "Blue") == 0)  { c = Blue; return true; }
+	return false;
+}
+
+/// Has serializer methods for both formats
+struct Point {
+	Point () : x (0), y (0), color (Red) {}
+	int x;
+	double y;
+	Color color;
+	std::string name;
+
+	void serialize (sf::BinarySerialization & s) const {
+		s ("x", x);
+		s ("y", y);
+		s ("color", color);
+		s ("name", name);
+	}
+
+	bool deserialize (const sf::BinaryDeserialization & d) {
+		bool suc = true;
+		suc = d ("x", x) && suc;
+		suc = d ("y", y) && suc;
+		suc = d ("color", color) && suc;
+		suc = d ("name", name) && suc;
+		return suc;
+	}
+
+	bool operator== (const Point & other) const {
+		return x == other.x && y == other.y && color == other.color && name == other.name;
+	}
+};
+
+/// Only has JSON methods, will be embedded as JSON
+struct JsonOnly {
+	JsonOnly () : value (0) {}
+	int value;
+
+	void serialize (sf::Serialization & s) const {
+		s ("value", value);
+	}
+
+	bool deserialize (const sf::Deserialization & d) {
+		return d ("value", value);
+	}
+};
+
+bool plainSerialization () {
+	{
+		int x = -5;
+		int y = 0;
+		bool suc = sf::fromBinary (sf::toBinary (x), y);
+		tassert (suc && x == y);
+	}
+	{
+		int64_t x = 1234567890123LL;
+		int64_t y = 0;
+		bool suc = sf::fromBinary (sf::toBinary (x), y);
+		tassert (suc && x == y);
+	}
+	{
+		float x = 3.14159f;
+		float y = 0;
+		bool suc = sf::fromBinary (sf::toBinary (x), y);
+		tassert (suc && x == y);
+	}
+	{
+		std::string x = "Its a tricky\nString\"";
+		std::string y;
+		bool suc = sf::fromBinary (sf::toBinary (x), y);
+		tassert (suc && x == y);
+	}
+	{
+		std::vector<int> x; x.push_back (3); x.push_back (-400); x.push_back (70000);
+		std::vector<int> y;
+		bool suc = sf::fromBinary (sf::toBinary (x), y);
+		tassert (suc && x == y);
+	}
+	{
+		std::vector<bool> x; x.push_back (true); x.push_back (false); x.push_back (true);
+		std::vector<bool> y (5, false);
+		bool suc = sf::fromBinary (sf::toBinary (x), y);
+		tassert (suc && x == y);
+	}
+	{
+		std::map<std::string, double> x; x["a"] = 1.5; x["b"] = -2.25;
+		std::map<std::string, double> y;
+		bool suc = sf::fromBinary (sf::toBinary (x), y);
+		tassert (suc && x == y);
+	}
+	{
+		std::pair<int, std::string> x (5, "five");
+		std::pair<int, std::string> y;
+		bool suc = sf::fromBinary (sf::toBinary (x), y);
+		tassert (suc && x == y);
+	}
+	return true;
+}
+
+bool objectSerialization () {
+	Point p;
+	p.x = 17;
+	p.y = -0.5;
+	p.color = Blue;
+	p.name = "Point";
+	std::vector<Point> points (3, p);
+	std::string data = sf::toBinary (points);
+
+	std::vector<Point> back;
+	bool suc = sf::fromBinary (data, back);
+	tassert (suc && back == points);
+
+	// key order doesn't matter and missing keys are default
+	Point q;
+	suc = sf::fromBinary (sf::toBinaryEx (Point(), sf::COMPRESS), q);
+	tassert (suc && q == Point ());
+
+	// truncated data must be detected
+	Point r;
+	std::string truncated = sf::toBinary (p);
+	truncated.resize (truncated.size() - 2);
+	tassert (!sf::fromBinary (truncated, r));
+	return true;
+}
+
+bool jsonFallback () {
+	JsonOnly x;
+	x.value = 42;
+	std::string data = sf::toBinary (x);
+	tassert (data[0] == sf::binary::JsonTag);
+	JsonOnly y;
+	bool suc = sf::fromBinary (data, y);
+	tassert (suc && y.value == 42);
+	return true;
+}
+
+int main (int argc, char * argv[]){
+	RUN (plainSerialization());
+	RUN (objectSerialization());
+	RUN (jsonFallback());
+	return 0;
+}
@@ -160,7 +160,190 @@ void jsonParserTest () {
 	}
 }
 
+void pathQueryTest () {
+	std::string json = "{\"orders\": [ {\"price\": 1}, {\"price\": 2.5, \"skip\": \"]}\"} ], \"a/b\": {\"m~n\": true}, \"user\": {\"name\": \"Bob\"}}";
+	double price = 0;
+	tassert (sf::json::query (json.c_str(), json.length(), "/orders/1/price").fetch (price) && price == 2.5);
+	bool b = false;
+	tassert (sf::json::query (json.c_str(), json.length(), "/a~1b/m~0n").fetch (b) && b);
+	tassert (!sf::json::query (json.c_str(), json.length(), "/orders/2").valid());
+	tassert (!sf::json::query (json.c_str(), json.length(), "/orders/01").valid());
+	tassert (!sf::json::query (json.c_str(), json.length(), "no pointer").valid());
+	tassert (sf::json::query (json.c_str(), json.length(), "").type() == sf::json::ObjectType);
+
+	// relative to a value
+	sf::json::Value user = sf::json::query (json.c_str(), json.length(), "/user");
+	std::string name;
+	tassert (sf::json::query (user, "/name").fetch (name) && name == "Bob");
+
+	// multiple paths in one pass
+	sf::json::PathQuery query;
+	int p0 = query.add ("/orders/0/price");
+	int p1 = query.add ("/user/name");
+	int p2 = query.add ("/missing");
+	int p3 = query.add ("/orders/0/price");
+	tassert (p0 == p3 && query.count() == 3);
+	std::vector<sf::json::Value> results;
+	query.run (json.c_str(), json.length(), results);
+	int64_t i = 0;
+	tassert (results[p0].fetch (i) && i == 1);
+	tassert (results[p1].fetch (name) && name == "Bob");
+	tassert (!results[p2].valid());
+}
+
+void lazyArrayTest () {
+	std::string json = "[";
+	for (int i = 0; i < 1000; i++) {
+		if (i > 0) json += ", ";
+		json += (i % 2) ? "{\"x\": [1, 2]}" : "7";
+	}
+	json += "]";
+	sf::json::LazyArray array (json.c_str(), json.length());
+	tassert (!array.error());
+	int64_t x = 0;
+	tassert (array.get (998).fetch (x) && x == 7);		// scans forward
+	tassert (array.get (64).fetch (x) && x == 7);		// from a checkpoint
+	tassert (array.get (65).type() == sf::json::ObjectType);	// from the cursor
+	tassert (!array.get (1000).valid() && !array.get (-1).valid());
+	tassert (array.count() == 1000 && !array.error());
+	int objects = 0;
+	for (int i = 0; i < array.count(); i++) {
+		if (array.get (i).type() == sf::json::ObjectType) objects++;
+	}
+	tassert (objects == 500);
+
+	sf::json::LazyArray empty ("[ ]", 3);
+	tassert (!empty.error() && empty.count() == 0 && !empty.get (0).valid());
+
+	const char * broken = "[1, 2, }";
+	sf::json::LazyArray b (broken, strlen (broken));
+	tassert (b.get (1).valid() && !b.error());
+	tassert (!b.get (2).valid() && b.error());
+
+	sf::json::Value v = sf::json::parse ("[3, 4]");
+	sf::json::LazyArray a;
+	tassert (v.fetch (a) && a.count() == 2 && a.get (1).fetch (x) && x == 4);
+}
+
+void iteratorTest () {
+	std::string json = "[1, \"two\", {\"a\": 3, \"b\" : [4]}, ]";
+	sf::json::ArrayRange elements (json.c_str(), json.length());
+	int count = 0;
+	sf::json::Value object;
+	for (sf::json::ArrayIterator i = elements.begin(); i != elements.end(); ++i) {
+		if (i->type() == sf::json::ObjectType) object = *i;
+		count++;
+	}
+	tassert (count == 3 && !elements.error());
+
+	std::string keys;
+	sf::json::ObjectRange entries (object);
+	for (sf::json::ObjectIterator e = entries.begin(); e != entries.end(); ++e) {
+		keys += e->name();
+	}
+	tassert (keys == "ab" && !entries.error());
+
+	// early exit doesn't look at the rest
+	const char * broken = "[1, 2, !!!";
+	sf::json::ArrayRange b (broken, strlen (broken));
+	sf::json::ArrayIterator i = b.begin();
+	tassert (i != b.end() && (++i) != b.end() && !b.error());
+	tassert ((++i) == b.end() && b.error());
+
+	sf::json::ArrayRange noArray (object);
+	tassert (noArray.error() && noArray.begin() == noArray.end());
+	sf::json::ObjectRange empty (sf::json::parse ("{ }"));
+	tassert (!empty.error() && empty.begin() == empty.end());
+}
+
+void stringDecodingTest () {
+	std::string s;
+	bool suc = false;
+	sf::json::Value plain = sf::json::parse ("\"no escapes at all\"");
+	tassert (!plain.hasEscapes() && plain.fetch (s, true, &suc) && suc && s == "no escapes at all");
+
+	sf::json::Value v = sf::json::parse ("\"a\\\"b\\\\c\\/d\\n\\u0041\\u00e4\\u20AC\"");
+	tassert (v.hasEscapes() && v.fetch (s, true, &suc) && suc);
+	tassert (s == "a\"b\\c/d\nA\xc3\xa4\xe2\x82\xac");
+
+	// surrogate pair (U+1F600)
+	tassert (sf::json::parse ("\"\\ud83d\\ude00\"").fetch (s, true, &suc) && suc && s == "\xf0\x9f\x98\x80");
+
+	// lonely surrogates are replaced by U+FFFD
+	tassert (sf::json::parse ("\"x\\ud83dy\"").fetch (s, true, &suc) && !suc && s == "x\xef\xbf\xbdy");
+	tassert (sf::json::parse ("\"\\ude00\"").fetch (s, true, &suc) && !suc && s == "\xef\xbf\xbd");
+	tassert (sf::json::parse ("\"\\u12G4\"").fetch (s, true, &suc) && !suc);
+
+	// flags are recorded while scanning, non ASCII strings get validated
+	tassert (plain.isAscii() && v.isAscii());
+	sf::json::Value utf8 = sf::json::parse ("\"\xc3\xa4\"");
+	tassert (!utf8.isAscii() && !utf8.hasEscapes() && utf8.fetch (s, true, &suc) && suc && s == "\xc3\xa4");
+	tassert (sf::json::parse ("\"\xc3(\"").fetch (s, true, &suc) && !suc);
+	tassert (sf::json::parse ("\"\xed\xa0\x80\"").fetch (s, true, &suc) && !suc);	// encoded surrogate
+	tassert (sf::json::parse ("\"\xc0\xaf\"").fetch (s, true, &suc) && !suc);		// overlong
+
+	// escaped backslash right before the closing quote
+	sf::json::Object o ("{\"a\" : \"b\\\\\", \"c\" : [\"\\\\\"], \"d\" : 1}");
+	tassert (!o.error());
+	tassert (o.get ("a").fetch (s, true) && s == "b\\");
+	int64_t x = 0;
+	tassert (o.get ("d").fetch (x) && x == 1);
+}
+
+void utf8ValidationTest () {
+	// long enough to use the block wise ASCII check
+	std::string valid = "{\"name\" : \"A longer ASCII text before \xc3\xa4 and after \xe2\x82\xac\", \"list\" : [\"\xf0\x9f\x98\x80\", {\"x\" : \"\xc3\xa4\"}]}";
+	sf::json::Object o;
+	o.init (valid.c_str(), valid.length(), 0, sf::json::ValidateUtf8);
+	tassert (!o.error());
+	tassert (sf::json::parse (valid.c_str(), valid.length(), sf::json::ValidateUtf8).valid());
+
+	const char * invalid [] = {
+		"{\"name\" : \"A longer ASCII text before \xc3( and after\"}",	// broken continuation
+		"{\"list\" : [1, {\"x\" : \"\xed\xa0\x80\"}]}",					// nested, encoded surrogate
+		"{\"\xff\" : 1}",												// key
+		"{\"x\" : \"\xe2\x82\"}"										// truncated
+	};
+	for (size_t i = 0; i < sizeof (invalid) / sizeof (invalid[0]); i++) {
+		sf::json::Object p (invalid[i]);
+		tassert (!p.error());	// not checked by default
+		p.init (invalid[i], -1, 0, sf::json::ValidateUtf8);
+		tassert (p.error());
+		tassert (!sf::json::parse (invalid[i], -1, sf::json::ValidateUtf8).valid());
+	}
+
+	// also skipped values are validated
+	sf::FieldMask mask ("name");
+	sf::json::Object masked;
+	masked.init (invalid[1], -1, &mask, sf::json::ValidateUtf8);
+	tassert (masked.error());
+}
+
+void keyHashTest () {
+	const char * json = "{\"alpha\" : 1, \"beta\" : 2, \"\" : 3}";
+	sf::json::Object o (json);
+	tassert (!o.error());
+	for (const sf::json::Entry * e = o.first(); e; e = e->next()) {
+		sf::StringView name = e->nameView();
+		tassert (e->nameHash() == sf::json::keyHash (name.data(), (int) name.size()));
+	}
+	int64_t x = 0;
+	tassert (o.get (sf::json::Key ("beta", 4, sf::json::keyHash ("beta", 4))).fetch (x) && x == 2);
+	tassert (o.get ("").fetch (x) && x == 3);
+	tassert (!o.get ("alph").valid() && !o.get ("alphaa").valid());
+
+	// also set by the iterators
+	sf::json::ObjectRange entries (sf::json::parse (json));
+	tassert (entries.begin()->nameHash() == sf::json::keyHash ("alpha", 5));
+}
+
 int main (int argc, char * argv[]){
 	jsonParserTest ();
+	pathQueryTest ();
+	lazyArrayTest ();
+	iteratorTest ();
+	stringDecodingTest ();
+	utf8ValidationTest ();
+	keyHashTest ();
 	return 0;
 }
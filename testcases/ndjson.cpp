@@ -0,0 +1,109 @@
+#include "test.h"
+#include <sfserialization/NDJSON.h>
+#include <boost/bind.hpp>
+
+/*
+ * Tests reading / writing newline delimited JSON
+ */
+
+struct Record {
+	Record () : id (0) {}
+	int id;
+	std::string text;
+
+	void serialize (sf::Serialization & s) const {
+		s ("id", id);
+		s ("text", text);
+	}
+
+	bool deserialize (const sf::Deserialization & d) {
+		bool suc = true;
+		suc = d ("id", id) && suc;
+		suc = d ("text", text) && suc;
+		return suc;
+	}
+};
+
+bool readWrite () {
+	std::string data;
+	sf::NDJSONWriter writer (data);
+	for (int i = 0; i < 10; i++) {
+		Record r;
+		r.id = i;
+		r.text = "Line\nwith newline";
+		writer.write (r);
+	}
+	sf::NDJSONReader reader (data);
+	Record r;
+	int count = 0;
+	while (reader.next (r)) {
+		tassert (r.id == count && r.text == "Line\nwith newline");
+		count++;
+	}
+	tassert (!reader.error() && count == 10);
+	return true;
+}
+
+bool emptyAndInvalidLines () {
+	std::string data = "{\"id\":1}\r\n\n   \n{\"id\":2 BROKEN\n{\"id\":3}";
+	sf::NDJSONReader reader (data);
+	Record r;
+	tassert (reader.next (r) && r.id == 1);
+	tassert (!reader.next (r) && reader.error() && reader.lineNumber() == 4);
+	tassert (reader.next (r) && r.id == 3);
+	tassert (!reader.next (r) && !reader.error());
+	return true;
+}
+
+bool indentedLines () {
+	std::string data = "  {\"id\":1}\n\t[1,2]\r\n";
+	sf::NDJSONReader reader (data);
+	Record r;
+	tassert (reader.next (r) && r.id == 1);
+	sf::json::Value v;
+	tassert (reader.next (v) && v.type() == sf::json::ArrayType);
+	tassert (!reader.next (v) && !reader.error());
+	return true;
+}
+
+/// Sums up the ids of dispatched records
+struct Summer {
+	Summer () : sum (0), invalid (0) {}
+	void handle (const sf::json::Value & v) {
+		Record r;
+		bool suc = sf::deserialize (v, r);
+		boost::mutex::scoped_lock lock (mutex);
+		if (suc) sum += r.id;
+		else invalid++;
+	}
+	boost::mutex mutex;
+	int64_t sum;
+	int invalid;
+};
+
+bool dispatch () {
+	std::string data;
+	sf::NDJSONWriter writer (data, sf::COMPRESS);
+	int64_t expected = 0;
+	for (int i = 0; i < 10000; i++) {
+		Record r;
+		r.id = i;
+		writer.write (r);
+		expected += i;
+	}
+	data += "invalid\n";
+	sf::ThreadPool pool (4);
+	Summer summer;
+	sf::NDJSONReader reader (data);
+	reader.dispatch (pool, boost::bind (&Summer::handle, &summer, _1), 100);
+	tassert (summer.sum == expected && summer.invalid == 1);
+	return true;
+}
+
+int main (int argc, char * argv[]){
+	RUN (readWrite());
+	RUN (emptyAndInvalidLines());
+	RUN (indentedLines());
+	RUN (dispatch());
+	return 0;
+}
@@ -0,0 +1,106 @@
+#include "test.h"
+#include <sfserialization/Parallel.h>
+
+/*
+ * Tests the parallel (de)serialization of big arrays
+ */
+
+struct Element {
+	Element () : id (0), value (0) {}
+	int id;
+	double value;
+	std::string name;
+	std::vector<int> data;
+
+	void serialize (sf::Serialization & s) const {
+		s ("id", id);
+		s ("value", value);
+		s ("name", name);
+		s ("data", data);
+	}
+
+	bool deserialize (const sf::Deserialization & d) {
+		bool suc = true;
+		suc = d ("id", id) && suc;
+		suc = d ("value", value) && suc;
+		suc = d ("name", name) && suc;
+		suc = d ("data", data) && suc;
+		return suc;
+	}
+
+	bool operator== (const Element & other) const {
+		return id == other.id && value == other.value && name == other.name && data == other.data;
+	}
+};
+
+static std::vector<Element> createElements (int count) {
+	std::vector<Element> result (count);
+	for (int i = 0; i < count; i++) {
+		result[i].id    = i;
+		result[i].value = i * 0.5;
+		result[i].name  = "Element";
+		result[i].data.push_back (i);
+	}
+	return result;
+}
+
+bool parallelDeserialization () {
+	sf::ThreadPool pool (4);
+	std::vector<Element> elements = createElements (10000);
+	std::string json = sf::toJSON (elements);
+
+	std::vector<Element> serial;
+	std::vector<Element> parallel;
+	bool suc = sf::fromJSON (json, serial);
+	tassert (suc && serial == elements);
+	suc = sf::fromJSONParallel (json, parallel, pool);
+	tassert (suc && parallel == serial);
+
+	// update mode of the caller is respected by the worker threads
+	{
+		const int * storage = &parallel[42].data[0];
+		sf::DeserializationScope scope (0, true);
+		suc = sf::fromJSONParallel (json, parallel, pool);
+		tassert (suc && parallel == serial && &parallel[42].data[0] == storage);
+	}
+
+	// small arrays
+	suc = sf::fromJSONParallel ("[]", parallel, pool);
+	tassert (suc && parallel.empty());
+
+	// error in the middle must leave the same result as serial
+	elements[5000].name = "BROKEN";
+	json = sf::toJSON (elements);
+	size_t p = json.find ("\"BROKEN\"");
+	json.replace (p, 8, "[1,2]"); // wrong type
+	suc = sf::fromJSON (json, serial);
+	tassert (!suc && serial.size() == 5000);
+	suc = sf::fromJSONParallel (json, parallel, pool);
+	tassert (!suc && parallel == serial);
+
+	// bit vectors are read serially
+	std::vector<bool> flags;
+	suc = sf::fromJSONParallel ("[true, false, true]", flags, pool);
+	tassert (suc && flags.size() == 3 && flags[0] && !flags[1] && flags[2]);
+	return true;
+}
+
+bool parallelSerialization () {
+	sf::ThreadPool pool (4);
+	std::vector<Element> elements = createElements (10000);
+	elements[20].name = "";
+	elements[20].data.clear ();
+	tassert (sf::toJSONParallel (elements, pool) == sf::toJSON (elements));
+	int flags = sf::COMPRESS | sf::INDENT;
+	tassert (sf::toJSONParallel (elements, pool, flags) == sf::toJSONEx (elements, flags));
+	tassert (sf::toJSONParallel (std::vector<Element> (), pool) == sf::toJSON (std::vector<Element> ()));
+	std::vector<Element> small = createElements (1);
+	tassert (sf::toJSONParallel (small, pool) == sf::toJSON (small));
+	return true;
+}
+
+int main (int argc, char * argv[]){
+	RUN (parallelDeserialization());
+	RUN (parallelSerialization());
+	return 0;
+}
@@ -1,5 +1,7 @@
 #include <sfserialization/Serialization.h>
 #include <sfserialization/Deserialization.h>
+#include <sfserialization/BinarySerialization.h>
+#include <sfserialization/BinaryDeserialization.h>
 
 #include "performance.h"
 #include "test.h"
@@ -29,11 +31,36 @@ void testrun (int depth, int iterations) {
 	printf ("\n");
 }
 
+void testrunBinary (int depth, int iterations) {
+	TestObject object;
+	object.generateData (depth);
+	long size  = object.size();
+	long bytes = 0;
+	double t0 = microtime();
+	for (int i = 0; i < iterations; i++) {
+		std::string data = sf::toBinary (object);
+		bytes +=data.size();
+		TestObject object2;
+		bool suc = sf::fromBinary (data, object2);
+		tassert (suc);
+	}
+	double t1 = microtime ();
+	double t = t1 - t0;
+	long elements = size * iterations;
+	printf ("Binary testrun with depth %d and %d iterations  (single element size: %ld)\n", depth, iterations, size);
+	printf ("  Parsed %ld elements (%ld bytes) in %f seconds\n", elements, bytes, t);
+	printf ("  1000 Elements per second: %f\n", elements / t / 1000);
+	printf ("  MiB per second:           %f\n", bytes / t / (1024 * 1024));
+	printf ("\n");
+}
+
 int main (int argc, char * argv[]){
 	testrun (7, 1);
 	testrun (5, 20);
 	testrun (1, 10000);
 	testrun (0, 100000);
+	testrunBinary (5, 20);
+	testrunBinary (0, 100000);
 	return 0;
 }
 
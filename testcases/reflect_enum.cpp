@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include "test.h"
 #include <sfserialization/isdefault.h>
+#include <sfserialization/Deserialization.h>
 
 template <class E>
 bool checkFromString (const std::string & s, E e){
@@ -71,5 +72,21 @@ int main (int argc, char * argv[]){
 
 	tassert (testBitEnum());
 
+	// length aware fromString, the string needs not to be 0-terminated
+	TestEnum x = Alpha;
+	const char * text = "GammaDelta";
+	tassert (fromString (text, 5, x) && x == Gamma);
+	tassert (fromString (text + 5, 5, x) && x == Delta);
+	tassert (!fromString (text, 4, x) && !fromString (text, 0, x));
+	TestEmptyEnum empty;
+	tassert (!fromString ("", 0, empty));
+
+	// used by deserialize without copying
+	tassert (sf::hasLengthFromString<TestEnum>::value);
+	tassert (sf::fromJSON (std::string ("\"Beta\""), x) && x == Beta);
+	tassert (!sf::fromJSON (std::string ("\"Bet\""), x));
+	Bla::BlaEnum b;
+	tassert (sf::fromJSON (std::string ("\"C\""), b) && b == Bla::C);
+
 	return 0;
 }
@@ -1,7 +1,23 @@
 #include "reflect_rpc.h"
 #include "test.h"
+#include <sstream>
+#include <stdexcept>
 #include <sfserialization/Deserialization.h>
 
+std::vector<PendingCall> gPendingCalls;
+
+void ReusingControllable::onRpc (const sf::HostId & sender, const BulkCommand & cmd, const sf::ByteArray & data) {
+	if (cmd.fail) throw std::runtime_error ("bulk command failed");
+	if (cmd.nested) {
+		// recursive call of the same command must not overwrite cmd
+		handleRpc (sender, "bulkCommand", std::string ("{\"values\":[7]}"));
+		mNestedParameter = mLastParameter;
+		if (!cmd.nested) mNestedOverwrite = true;
+	}
+	mLastParameter = &cmd;
+	mCapacity = cmd.values.capacity();
+}
+
 int main (int argc, char * argv[]) {
 	RpcControlleable controllable;
 
@@ -28,8 +44,91 @@ int main (int argc, char * argv[]) {
 	// error stuff
 	suc = controllable.handleRpc ("They", "invalidCommand", std::string ("{}"));
 	tassert (!suc, "must recognize invalid commands");
+	suc = controllable.handleRpc ("They", "sampleComman", std::string ("{}"));
+	tassert (!suc, "must not accept prefixes");
+	suc = controllable.handleRpc ("They", "", std::string ("{}"));
+	tassert (!suc, "must not accept empty commands");
+	suc = controllable.handleRpc ("You", "sampleCommand", std::string ("{\"msg\":5}"));
+	tassert (!suc, "must recognize wrong parameters");
 	suc = controllable.handleRpc ("You", "sampleCommand", std::string ("{parsing error}"));
 	tassert (!suc, "must recognize invalid serialization");
 
+	// payloads
+	{
+		const char buffer[] = "binary payload";
+		sf::ByteView view (buffer, sizeof (buffer) - 1);
+		suc = controllable.handleRpc ("Me", "binaryCommand", std::string ("{\"id\":1}"), view);
+		tassert (suc && controllable.payload() == "binary payload");
+		tassert (controllable.payloadPointer() == buffer, "views must be passed without copy");
+		sf::ByteArray array (buffer, buffer + 6);
+		suc = controllable.handleRpc ("Me", "binaryCommand", std::string ("{\"id\":2}"), array);
+		tassert (suc && controllable.payload() == "binary");
+		suc = controllable.handleRpc ("Me", "binaryCommand", std::string ("{\"id\":3}"));
+		tassert (suc && controllable.payload().empty());
+		// ByteArray handlers still work with views
+		suc = controllable.handleRpc ("Me", "sampleCommand", std::string ("{\"msg\":\"view\"}"), view);
+		tassert (suc && controllable.received() == "view");
+	}
+
+	// handlers with results
+	suc = controllable.handleRpc ("Me", "checkedCommand", std::string ("{\"accept\":true}"));
+	tassert (suc);
+	suc = controllable.handleRpc ("Me", "checkedCommand", std::string ("{\"accept\":false}"));
+	tassert (!suc, "bool handlers decide about the result");
+	suc = controllable.handleRpc ("Me", "asyncCommand", std::string ("{\"id\":42}"));
+	tassert (suc && gPendingCalls.size() == 1 && gPendingCalls[0].id == 42, "asynchronous results must be handed off");
+
+	// batch handling, grouped by command but in order within one command
+	{
+		RpcControlleable batched;
+		sf::String cmds[] = { "sampleCommand", "otherCommand", "invalidCommand", "sampleCommand", "otherCommand" };
+		sf::Deserialization headers[] = {
+			sf::Deserialization (std::string ("{\"msg\":\"a\"}")),
+			sf::Deserialization (std::string ("{\"msg\":\"b\"}")),
+			sf::Deserialization (std::string ("{}")),
+			sf::Deserialization (std::string ("{\"msg\":5}")),
+			sf::Deserialization (std::string ("{\"msg\":\"c\"}"))
+		};
+		sf::HostId sender = "Me";
+		sf::ByteArray data;
+		std::vector<RpcControlleable::RpcCall> calls;
+		for (int i = 0; i < 5; i++) {
+			calls.push_back (RpcControlleable::RpcCall (sender, cmds[i], headers[i], data));
+		}
+		bool results[5];
+		int handled = batched.handleRpcBatch (&calls[0], calls.size(), results);
+		tassert (handled == 3);
+		tassert (results[0] && results[1] && !results[2] && !results[3] && results[4]);
+		tassert (batched.log() == "a;b;c;", "grouped by command");
+		tassert (batched.handleRpcBatch (0, 0) == 0);
+	}
+
+	// reusing parameter objects
+	{
+		ReusingControllable reusing;
+		std::ostringstream bulk;
+		bulk << "{\"values\":[0";
+		for (int i = 1; i < 100; i++) bulk << "," << i;
+		bulk << "]}";
+		tassert (reusing.handleRpc ("Me", "bulkCommand", bulk.str()));
+		const BulkCommand * first = reusing.lastParameter ();
+		tassert (reusing.handleRpc ("Me", "bulkCommand", std::string ("{\"values\":[1]}")));
+		tassert (reusing.lastParameter() == first, "parameter object must be reused");
+		tassert (reusing.capacity() >= 100, "storage must be kept");
+		tassert (reusing.handleRpc ("Me", "bulkCommand", std::string ("{\"values\":[1],\"nested\":true}")));
+		tassert (reusing.nestedParameter() != first && reusing.lastParameter() == first);
+		tassert (!reusing.nestedOverwrite(), "recursive calls must use an own parameter object");
+
+		bool thrown = false;
+		try {
+			reusing.handleRpc ("Me", "bulkCommand", std::string ("{\"values\":[1],\"fail\":true}"));
+		} catch (std::runtime_error &) {
+			thrown = true;
+		}
+		tassert (thrown);
+		tassert (reusing.handleRpc ("Me", "bulkCommand", std::string ("{\"values\":[2]}")));
+		tassert (reusing.lastParameter() == first, "a throwing handler must not disable the reuse");
+	}
+
 	return 0;
 }
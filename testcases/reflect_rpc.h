@@ -9,6 +9,11 @@ typedef std::string String;
 typedef std::string HostId;
 }
 
+// Names used by helpers of the generated code must not clash
+struct RpcResult { int code; };
+struct RpcArrayInvoker {};
+inline void callRpcHandler () {}
+
 struct SampleCommand {
 	sf::String msg;
 	SF_AUTOREFLECT_SDC;
@@ -19,20 +24,102 @@ struct OtherCommand {
 	SF_AUTOREFLECT_SDC;
 };
 
+struct BinaryCommand {
+	int id;
+	SF_AUTOREFLECT_SDC;
+};
+
+struct CheckedCommand {
+	bool accept;
+	SF_AUTOREFLECT_SDC;
+};
+
+struct AsyncCommand {
+	int id;
+	SF_AUTOREFLECT_SDC;
+};
+
+/// Result of an asynchronous rpc handler
+struct PendingCall {
+	int id;
+};
+
+/// Pending calls, handed off by the generated rpc code
+extern std::vector<PendingCall> gPendingCalls;
+
+namespace sf {
+template <> struct RpcAsyncTraits<PendingCall> {
+	static void handOff (const PendingCall & call) { gPendingCalls.push_back (call); }
+};
+}
+
 class RpcControlleable {
 public:
+	RpcControlleable () : mPayloadPointer (0) {}
 	SF_AUTOREFLECT_RPC;
 
 	/// what was the last package the controllable class received
 	const std::string & received () const { return mReceived; }
+	/// payload of last BinaryCommand
+	const std::string & payload () const { return mPayload; }
+	/// pointer to payload of last BinaryCommand (to check for copies)
+	const char * payloadPointer () const { return mPayloadPointer; }
+	/// all received messages in order of handling (separated by ';')
+	const std::string & log () const { return mLog; }
 private:
 	// rpc handlers
 	void onRpc (const sf::HostId & sender, const SampleCommand & cmd, const sf::ByteArray & data) {
 		mReceived = cmd.msg;
+		mLog += cmd.msg + ";";
 	}
 	void onRpc (const sf::HostId & sender, const OtherCommand & cmd, const sf::ByteArray & data) {
 		mReceived = cmd.msg;
+		mLog += cmd.msg + ";";
+	}
+
+	void onRpc (const sf::HostId & sender, const BinaryCommand & cmd, const sf::ByteView & data) {
+		mPayload.assign (data.begin(), data.end());
+		mPayloadPointer = data.data();
+	}
+
+	bool onRpc (const sf::HostId & sender, const CheckedCommand & cmd, const sf::ByteArray & data) {
+		return cmd.accept;
+	}
+	PendingCall onRpc (const sf::HostId & sender, const AsyncCommand & cmd, const sf::ByteView & data) {
+		PendingCall call;
+		call.id = cmd.id;
+		return call;
 	}
 
 	std::string mReceived;
+	std::string mPayload;
+	const char * mPayloadPointer;
+	std::string mLog;
+};
+
+struct BulkCommand {
+	std::vector<int> values;
+	bool nested;
+	bool fail;
+	SF_AUTOREFLECT_SDC;
+};
+
+/// Reuses the parameter objects of its rpc handlers
+class ReusingControllable {
+public:
+	ReusingControllable () : mLastParameter (0), mNestedParameter (0), mCapacity (0), mNestedOverwrite (false) {}
+	SF_AUTOREFLECT_RPC_REUSE;
+
+	const BulkCommand * lastParameter () const { return mLastParameter; }
+	const BulkCommand * nestedParameter () const { return mNestedParameter; }
+	size_t capacity () const { return mCapacity; }
+	/// a recursive call did overwrite the parameter of the outer call
+	bool nestedOverwrite () const { return mNestedOverwrite; }
+private:
+	void onRpc (const sf::HostId & sender, const BulkCommand & cmd, const sf::ByteArray & data);
+
+	const BulkCommand * mLastParameter;
+	const BulkCommand * mNestedParameter;
+	size_t mCapacity;
+	bool mNestedOverwrite;
 };
@@ -3,6 +3,9 @@
 
 #include <sfserialization/Serialization.h>
 #include <sfserialization/Deserialization.h>
+#include <sfserialization/BinarySerialization.h>
+#include <sfserialization/BinaryDeserialization.h>
+#include <sfserialization/LazyView.h>
 #include "test.h"
 
 bool testCyclus () {
@@ -130,6 +133,103 @@ bool testMapWithIntKey() {
 	return true;
 }
 
+bool testBinaryCyclus () {
+	other::OtherDerived d;
+	d.a = 5;
+	d.b = -3.5;
+	d.c = "Hi you are \"cool\"";
+	d.d.push_back (3);
+	d.keys["Alpha"] = "1";
+	d.x = 7;
+
+	std::string binary = sf::toBinary (d);
+	std::string json   = sf::toJSON (d);
+	printf ("Binary size: %d JSON size: %d\n", (int) binary.size(), (int) json.size());
+	tassert (binary.size() < json.size(), "Binary format shall be smaller");
+
+	other::OtherDerived d2;
+	bool suc = sf::fromBinary (binary, d2);
+	if (!suc) {
+		fprintf (stderr, "Binary deserialization failed\n");
+		return false;
+	}
+	if (!(d2 == d) || d2.x != d.x) {
+		fprintf (stderr, "Binary serialization does not match deserialization\n");
+		fprintf (stderr, "Deserialized: %s\n", sf::toJSON (d2).c_str());
+		return false;
+	}
+
+	my::Compound c;
+	c.sub2.keys["Beta"] = "2";
+	my::Compound c2;
+	suc = sf::fromBinary (sf::toBinary (c), c2);
+	return suc && c2.sub2 == c.sub2 && c2.sub1 == c.sub1;
+}
+
+bool testBinaryFieldIds () {
+	other::OtherDerived d;
+	d.a = 5;
+	d.c = "Field ids";
+	d.keys["Alpha"] = "1";
+	d.x = 7;
+
+	// base classes are stored in sub objects
+	other::OtherDerived d2;
+	bool suc = sf::fromBinary (sf::toBinaryEx (d, sf::FIELD_IDS), d2);
+	tassert (suc && d2 == d && d2.x == d.x, "Field id roundtrip failed");
+
+	my::WithFieldIds w;
+	w.id = 3;
+	w.value = 2.5;
+	w.comment = "Explicit id";
+	std::string named = sf::toBinary (w);
+	std::string ids   = sf::toBinaryEx (w, sf::FIELD_IDS);
+	printf ("Binary size with names: %d with field ids: %d\n", (int) named.size(), (int) ids.size());
+	tassert (ids.size() < named.size(), "Field ids shall be smaller than key names");
+	my::WithFieldIds w2;
+	suc = sf::fromBinary (ids, w2);
+	tassert (suc && w2 == w, "Explicit field ids failed");
+
+	my::WithSparseFieldIds sparse;
+	sparse.a = 1;
+	sparse.b = 2;
+	sparse.c = "sparse";
+	my::WithSparseFieldIds sparse2;
+	suc = sf::fromBinary (sf::toBinaryEx (sparse, sf::FIELD_IDS), sparse2);
+	tassert (suc && sparse2 == sparse, "Sparse field ids failed");
+
+	my::Compound c;
+	c.sub2.keys["Beta"] = "2";
+	c.sub2.a = 4;
+	my::Compound c2;
+	suc = sf::fromBinary (sf::toBinaryEx (c, sf::FIELD_IDS | sf::COMPRESS), c2);
+	return suc && c2.sub2 == c.sub2 && c2.sub1 == c.sub1;
+}
+
+bool testLazyView () {
+	other::OtherDerived d;
+	d.a = 5;
+	d.c = "Lazy";
+	d.keys["Alpha"] = "1";
+	d.x = 7;
+	sf::LazyView<other::OtherDerived> view (sf::toJSON (d));
+	tassert (!view.error());
+	tassert (view.get (&other::OtherDerived::x) == 7);
+	tassert (view.get (&my::Base::c) == "Lazy");			// member of a base class
+	tassert (view.get (&my::Derived::keys) == d.keys);
+	tassert (view.get (&my::Base::a) == 5 && !view.failed());
+
+	other::OtherDerived full;
+	tassert (view.fetch (full) && full == d && full.x == 7);
+
+	// wrong type
+	sf::LazyView<my::Base> broken (std::string ("{\"a\":\"no number\", \"c\":\"valid\"}"));
+	tassert (broken.get (&my::Base::c) == "valid" && !broken.failed());
+	broken.get (&my::Base::a);
+	tassert (broken.failed());
+	return true;
+}
+
 int main (int argc, char * argv[]) {
 	my::Base     b;
 	my::Derived  d;
@@ -162,6 +262,9 @@ int main (int argc, char * argv[]) {
 	RUN (testPrivateAvoidance1());
 	RUN (testPrivateAvoidance2());
 	RUN (testMapWithIntKey());
+	RUN (testBinaryCyclus());
+	RUN (testBinaryFieldIds());
+	RUN (testLazyView());
 	
 	return 0;
 }
@@ -60,6 +60,34 @@ struct MapWithIntKey {
 	std::map<int, std::string> values;
 	SF_AUTOREFLECT_SD;
 };
+
+// Explicit field ids for the binary format
+struct WithFieldIds {
+	WithFieldIds () : id (0), value (0) {}
+	int         id;
+	double      value;
+	std::string comment;
+	bool operator== (const WithFieldIds & other) const {
+		return id == other.id && value == other.value && comment == other.comment;
+	}
+	SF_AUTOREFLECT_FIELDID (comment, 10);
+	SF_AUTOREFLECT_SD;
+};
+
+// Sparse field ids (no lookup table when reading)
+struct WithSparseFieldIds {
+	WithSparseFieldIds () : a (0), b (0) {}
+	int         a;
+	int         b;
+	std::string c;
+	bool operator== (const WithSparseFieldIds & other) const {
+		return a == other.a && b == other.b && c == other.c;
+	}
+	SF_AUTOREFLECT_FIELDID (a, 100);
+	SF_AUTOREFLECT_FIELDID (b, 200);
+	SF_AUTOREFLECT_FIELDID (c, 300);
+	SF_AUTOREFLECT_SD;
+};
 	
 
 }
@@ -0,0 +1,112 @@
+#include "rpc_dispatcher.h"
+#include "test.h"
+#include <sfserialization/RpcDispatcher.h>
+#include <sstream>
+
+/*
+ * Tests routing RPC frames to different executors with sf::RpcDispatcher
+ */
+
+static std::string header (int seq) {
+	std::ostringstream ss;
+	ss << "{\"seq\":" << seq << "}";
+	return ss.str();
+}
+
+static bool inOrder (const std::vector<int> & received, int count) {
+	if ((int) received.size() != count) return false;
+	for (int i = 0; i < count; i++) {
+		if (received[i] != i) return false;
+	}
+	return true;
+}
+
+bool inlineExecution () {
+	Service service;
+	sf::RpcDispatcher<Service> dispatcher (service);
+	tassert (dispatcher.dispatch ("a", "fastCommand", header (0)));
+	tassert (service.received ("a").size() == 1, "inline commands are handled immediately");
+	tassert (!dispatcher.dispatch ("a", "unknownCommand", header (1)));
+	tassert (!dispatcher.dispatch ("a", "fastCommand", "{\"seq\":\"wrong\"}"));
+	tassert (dispatcher.handled() == 2 && dispatcher.failed() == 1);
+	tassert (service.foreignCalls (boost::this_thread::get_id()) == 0);
+	return true;
+}
+
+bool executorConfiguration () {
+	Service service;
+	sf::RpcDispatcher<Service> dispatcher (service);
+	tassert (!dispatcher.setExecutor ("slowCommand", sf::RpcDispatcherBase::Pool), "no pool given");
+	tassert (!dispatcher.setExecutor ("unknownCommand", sf::RpcDispatcherBase::Dedicated));
+	tassert (dispatcher.setExecutor ("slowCommand", sf::RpcDispatcherBase::Dedicated));
+	return true;
+}
+
+bool orderedExecution () {
+	sf::ThreadPool pool (4);
+	Service service;
+	sf::RpcDispatcher<Service> dispatcher (service, &pool);
+	tassert (dispatcher.setExecutor ("slowCommand", sf::RpcDispatcherBase::Pool));
+	tassert (dispatcher.setExecutor ("backgroundCommand", sf::RpcDispatcherBase::Dedicated));
+
+	const char * senders[] = { "a", "b", "c", "d", "e", "f" };
+	const char * commands[] = { "fastCommand", "slowCommand", "backgroundCommand", "slowCommand" };
+	const int count = 40;
+	for (int i = 0; i < count; i++) {
+		for (int s = 0; s < 6; s++) {
+			tassert (dispatcher.dispatch (senders[s], commands[(i + s) % 4], header (i)));
+		}
+	}
+	dispatcher.wait ();
+	tassert (dispatcher.handled() == count * 6 && dispatcher.failed() == 0);
+	for (int s = 0; s < 6; s++) {
+		tassert (inOrder (service.received (senders[s]), count), "frames of one sender must stay in order");
+	}
+	tassert (service.foreignCalls (boost::this_thread::get_id()) > 0, "must use other threads");
+	return true;
+}
+
+bool inlineSuccessors () {
+	sf::ThreadPool pool (2);
+	Service service;
+	sf::RpcDispatcher<Service> dispatcher (service, &pool);
+	tassert (dispatcher.setExecutor ("slowCommand", sf::RpcDispatcherBase::Pool));
+	const int count = 20;
+	for (int i = 0; i < count; i++) {
+		tassert (dispatcher.dispatch ("a", i % 2 ? "fastCommand" : "slowCommand", header (i)));
+	}
+	dispatcher.wait ();
+	tassert (inOrder (service.received ("a"), count));
+	tassert (service.foreignCalls (boost::this_thread::get_id()) == count / 2, "inline frames must run in the dispatching thread");
+	return true;
+}
+
+bool throwingHandler () {
+	sf::ThreadPool pool (2);
+	Service service;
+	sf::RpcDispatcher<Service> dispatcher (service, &pool);
+	tassert (!dispatcher.dispatch ("a", "throwingCommand", header (0)), "inline exceptions count as failure");
+	tassert (dispatcher.dispatch ("a", "fastCommand", header (1)));
+
+	tassert (dispatcher.setExecutor ("throwingCommand", sf::RpcDispatcherBase::Pool));
+	tassert (dispatcher.setExecutor ("slowCommand", sf::RpcDispatcherBase::Dedicated));
+	tassert (dispatcher.dispatch ("b", "slowCommand", header (0)));
+	tassert (dispatcher.dispatch ("b", "throwingCommand", header (1)));
+	tassert (dispatcher.dispatch ("b", "slowCommand", header (2)));
+	tassert (dispatcher.dispatch ("b", "throwingCommand", header (3)));
+	tassert (dispatcher.dispatch ("b", "fastCommand", header (4)));
+	dispatcher.wait ();
+	tassert (inOrder (service.received ("a"), 2));
+	tassert (inOrder (service.received ("b"), 5), "the strand must continue after an exception");
+	tassert (dispatcher.handled() == 7 && dispatcher.failed() == 3);
+	return true;
+}
+
+int main (int argc, char * argv[]) {
+	RUN (inlineExecution());
+	RUN (executorConfiguration());
+	RUN (orderedExecution());
+	RUN (inlineSuccessors());
+	RUN (throwingHandler());
+	return 0;
+}
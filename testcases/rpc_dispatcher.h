@@ -0,0 +1,79 @@
+#pragma once
+#include <sfserialization/autoreflect.h>
+#include <sfserialization/Serialization.h>
+#include <boost/thread.hpp>
+#include <stdexcept>
+
+namespace sf {
+// Some types needed for compilation
+typedef ByteArrayBase ByteArray;
+typedef std::string String;
+typedef std::string HostId;
+}
+
+struct FastCommand {
+	int seq;
+	SF_AUTOREFLECT_SDC;
+};
+
+struct SlowCommand {
+	int seq;
+	SF_AUTOREFLECT_SDC;
+};
+
+struct BackgroundCommand {
+	int seq;
+	SF_AUTOREFLECT_SDC;
+};
+
+struct ThrowingCommand {
+	int seq;
+	SF_AUTOREFLECT_SDC;
+};
+
+/// Records the sequence numbers of all received commands for each sender (thread safe)
+class Service {
+public:
+	SF_AUTOREFLECT_RPC;
+
+	/// Received sequence numbers of a sender (in order of handling)
+	std::vector<int> received (const sf::HostId & sender) {
+		boost::mutex::scoped_lock lock (mMutex);
+		return mReceived[sender];
+	}
+
+	/// Number of commands handled outside the given thread
+	int foreignCalls (boost::thread::id caller) {
+		boost::mutex::scoped_lock lock (mMutex);
+		int count = 0;
+		for (size_t i = 0; i < mThreads.size(); i++) {
+			if (mThreads[i] != caller) count++;
+		}
+		return count;
+	}
+private:
+	void onRpc (const sf::HostId & sender, const FastCommand & cmd, const sf::ByteArray & data) {
+		record (sender, cmd.seq);
+	}
+	void onRpc (const sf::HostId & sender, const SlowCommand & cmd, const sf::ByteArray & data) {
+		boost::this_thread::sleep (boost::posix_time::milliseconds (1));
+		record (sender, cmd.seq);
+	}
+	void onRpc (const sf::HostId & sender, const BackgroundCommand & cmd, const sf::ByteArray & data) {
+		record (sender, cmd.seq);
+	}
+	void onRpc (const sf::HostId & sender, const ThrowingCommand & cmd, const sf::ByteArray & data) {
+		record (sender, cmd.seq);
+		throw std::runtime_error ("handler failed");
+	}
+
+	void record (const sf::HostId & sender, int seq) {
+		boost::mutex::scoped_lock lock (mMutex);
+		mReceived[sender].push_back (seq);
+		mThreads.push_back (boost::this_thread::get_id ());
+	}
+
+	boost::mutex mMutex;
+	std::map<sf::HostId, std::vector<int> > mReceived;
+	std::vector<boost::thread::id> mThreads;
+};
@@ -113,6 +113,266 @@ bool plainSerialization () {
 	return true;
 }
 
+struct Envelope {
+	std::string type;
+	std::string routingKey;
+	SubType payload;
+	std::vector<SubType> parts;
+
+	void serialize (sf::Serialization & s) const {
+		s ("type", type);
+		s ("routingKey", routingKey);
+		s ("payload", payload);
+		s ("parts", parts);
+	}
+
+	bool deserialize (const sf::Deserialization & d) {
+		bool suc = true;
+		suc = d ("type", type) && suc;
+		suc = d ("routingKey", routingKey) && suc;
+		suc = d ("payload", payload) && suc;
+		suc = d ("parts", parts) && suc;
+		return suc;
+	}
+};
+
+bool maskedDeserialization () {
+	Envelope e;
+	e.type = "Message";
+	e.routingKey = "a.b";
+	e.payload.a = 3;
+	e.payload.b = true;
+	e.parts.resize (2);
+	e.parts[1].a = 7;
+	e.parts[1].d = Gamma;
+	std::string json = sf::toJSON (e);
+
+	Envelope x;
+	x.routingKey = "untouched";
+	bool suc = sf::fromJSON (json, x, sf::FieldMask ("type, payload.a"));
+	tassert (suc && x.type == "Message" && x.routingKey == "untouched");
+	tassert (x.payload.a == 3 && !x.payload.b && x.parts.empty());
+
+	// masks are applied to the elements of vectors, whole sub objects can be selected
+	Envelope y;
+	suc = sf::fromJSON (json, y, sf::FieldMask ("parts.d,payload,payload.a"));
+	tassert (suc && y.type.empty() && y.parts.size() == 2);
+	tassert (y.parts[1].d == Gamma && y.parts[1].a == -5);
+	tassert (y.payload.a == 3 && y.payload.b);
+
+	// values of skipped keys are not checked for their type
+	suc = sf::fromJSON ("{\"type\":\"T\", \"routingKey\":[1,{\"x\":\"}\"}], \"payload\":5}", x, sf::FieldMask ("type"));
+	tassert (suc && x.type == "T");
+
+	// update mode: vector elements are decoded in place, unselected members are kept
+	Envelope z;
+	z.parts.resize (3);
+	z.parts[0].b = true;
+	const SubType * storage = &z.parts[0];
+	suc = sf::updateFromJSON (json, z, sf::FieldMask ("parts.a"));
+	tassert (suc && z.parts.size() == 2 && &z.parts[0] == storage);
+	tassert (z.parts[1].a == 7 && z.parts[0].b, "unselected members must be kept");
+	return true;
+}
+
+/// Writes data into a file
+static bool writeFile (const char * path, const std::string & data) {
+	FILE * f = fopen (path, "wb");
+	if (!f) return false;
+	bool suc = fwrite (data.c_str(), 1, data.size(), f) == data.size();
+	fclose (f);
+	return suc;
+}
+
+bool fileDeserialization () {
+	const char * path = "serialization_test.json";
+	Externizable e;
+	e.e1 = 42;
+	tassert (writeFile (path, sf::toJSON (e)));
+	Externizable back;
+	bool suc = sf::fromJSONFile (path, back);
+	tassert (suc && back.e1 == 42 && back.e2 == e.e2);
+
+	// a number directly at the end of the file (no terminating character)
+	tassert (writeFile (path, "12345"));
+	int x = 0;
+	suc = sf::fromJSONFile (path, x);
+	tassert (suc && x == 12345);
+
+	// same for literals
+	tassert (writeFile (path, "true"));
+	bool b = false;
+	suc = sf::fromJSONFile (path, b);
+	tassert (suc && b);
+
+	tassert (writeFile (path, ""));
+	tassert (!sf::fromJSONFile (path, back));
+	remove (path);
+	tassert (!sf::fromJSONFile (path, back));
+	return true;
+}
+
+/// Refers to the JSON code it was deserialized from
+struct Tag {
+	sf::StringView name;
+	sf::StringView value;
+
+	void serialize (sf::Serialization & s) const {
+		s ("name", name);
+		s ("value", value);
+	}
+
+	bool deserialize (const sf::Deserialization & d) {
+		bool suc = true;
+		suc = d ("name", name) && suc;
+		suc = d ("value", value) && suc;
+		return suc;
+	}
+};
+
+bool stringViews () {
+	std::string json = "{\"name\" : \"host\", \"value\" : \"alpha\"}";
+	Tag t;
+	bool suc = sf::fromJSON (json, t);
+	tassert (suc && t.name == "host" && t.value == "alpha");
+	tassert (t.name.data() > json.c_str() && t.name.data() < json.c_str() + json.size()); // no copy
+	Tag back;
+	std::string serialized = sf::toJSON (t);
+	tassert (sf::fromJSON (serialized, back) && back.name == "host" && back.value == "alpha");
+
+	// escapes would need decoding
+	tassert (!sf::fromJSON (std::string ("{\"name\" : \"a\\nb\"}"), t));
+
+	sf::json::Object o (json.c_str());
+	tassert (o.first()->nameView() == "name");
+
+	std::map<std::string, std::string> all;
+	sf::Deserialization d (o);
+	tassert (d.allFetch (all) && all.size() == 2 && all["value"] == "alpha");
+	return true;
+}
+
+/// Record with repetitive values
+struct Quote {
+	sf::InternedString symbol;
+	int price;
+
+	void serialize (sf::Serialization & s) const {
+		s ("symbol", symbol);
+		s ("price", price);
+	}
+
+	bool deserialize (const sf::Deserialization & d) {
+		bool suc = true;
+		suc = d ("symbol", symbol) && suc;
+		suc = d ("price", price) && suc;
+		return suc;
+	}
+};
+
+bool internedStrings () {
+	std::string json = "[{\"symbol\":\"ABC\", \"price\":1}, {\"symbol\":\"XYZ\", \"price\":2}, {\"symbol\":\"ABC\", \"price\":3}, {\"symbol\":\"X\\u0059Z\"}]";
+	std::vector<Quote> quotes;
+	sf::StringPool pool;
+	bool suc = sf::fromJSON (json, quotes, pool);
+	tassert (suc && quotes.size() == 4 && pool.size() == 2);
+	tassert (quotes[0].symbol == "ABC" && quotes[3].symbol == "XYZ");
+	tassert (quotes[0].symbol.c_str() == quotes[2].symbol.c_str());	// shared storage
+	tassert (quotes[1].symbol.c_str() == quotes[3].symbol.c_str());		// also decoded ones
+
+	// the pool is only active for its fromJSON call
+	std::vector<Quote> unpooled;
+	tassert (sf::fromJSON (json, unpooled) && unpooled[0].symbol == quotes[0].symbol);
+	tassert (unpooled[0].symbol.c_str() != unpooled[2].symbol.c_str());
+	tassert (!sf::DeserializationContext::current().pool);
+
+	std::vector<Quote> back;
+	tassert (sf::fromJSON (sf::toJSON (quotes), back) && back.size() == 4 && back[3].symbol == "XYZ");
+
+	// values outlive the pool
+	pool.clear ();
+	tassert (quotes[2].symbol == "ABC" && pool.size() == 0);
+	return true;
+}
+
+bool malformedContainers () {
+	std::vector<int> v (1, 5);
+	tassert (!sf::fromJSON ("[1 2]", v) && v.size() == 1 && v[0] == 5, "vector must stay untouched");
+	std::set<int> set;
+	set.insert (5);
+	tassert (!sf::fromJSON ("[1 2]", set) && set.size() == 1 && set.count (5));
+	std::map<std::string, int> map;
+	map["x"] = 5;
+	tassert (!sf::fromJSON ("{\"a\":1, \"b\"}", map) && map.size() == 1 && map["x"] == 5);
+
+	// element errors still leave the elements before the failing one
+	tassert (!sf::fromJSON ("[1, \"two\", 3]", v) && v.size() == 1 && v[0] == 1);
+	tassert (!sf::fromJSON ("[1, \"two\"]", set) && set.size() == 1 && set.count (1));
+
+	// in update mode the elements are decoded in place, malformed arrays end like failing elements
+	v.assign (3, 7);
+	tassert (!sf::updateFromJSON ("[1 2]", v) && v.size() == 1 && v[0] == 1);
+	return true;
+}
+
+/// Snapshot with nested containers
+struct Level {
+	std::string name;
+	std::vector<int> sizes;
+
+	void serialize (sf::Serialization & s) const {
+		s ("name", name);
+		s ("sizes", sizes);
+	}
+
+	bool deserialize (const sf::Deserialization & d) {
+		bool suc = true;
+		suc = d ("name", name) && suc;
+		suc = d ("sizes", sizes) && suc;
+		return suc;
+	}
+};
+
+bool updateInPlace () {
+	std::string first  = "[{\"name\":\"a rather long level name\", \"sizes\":[1,2,3,4]}, {\"name\":\"another long level name\", \"sizes\":[5,6]}]";
+	std::string second = "[{\"name\":\"a changed level name\", \"sizes\":[7,8]}, {\"sizes\":[9,10,11]}]";
+	std::vector<Level> levels;
+	tassert (sf::updateFromJSON (first, levels) && levels.size() == 2);
+	const Level * storage      = &levels[0];
+	const char * nameStorage   = levels[0].name.c_str();
+	const int * sizesStorage   = &levels[0].sizes[0];
+	size_t nameCapacity        = levels[1].name.capacity();
+
+	// same shape: existing elements and buffers are reused
+	tassert (sf::updateFromJSON (second, levels) && levels.size() == 2);
+	tassert (levels[0].name == "a changed level name" && levels[0].sizes.size() == 2 && levels[1].sizes[2] == 11);
+	tassert (&levels[0] == storage && levels[0].name.c_str() == nameStorage && &levels[0].sizes[0] == sizesStorage);
+	tassert (levels[1].name.empty() && levels[1].name.capacity() == nameCapacity, "missing members keep their storage");
+	tassert (!sf::DeserializationContext::current().updateInPlace);
+
+	// different sizes
+	tassert (sf::updateFromJSON ("[{\"name\":\"x\"}]", levels) && levels.size() == 1 && levels[0].name == "x" && levels[0].sizes.empty());
+	tassert (sf::updateFromJSON (first, levels) && levels.size() == 2 && levels[1].sizes.size() == 2);
+	tassert (!sf::updateFromJSON ("[{\"name\":\"x\"}, {\"name\":5}]", levels) && levels.size() == 1);
+
+	// results are the same as with a fresh object
+	std::vector<Level> fresh;
+	tassert (sf::updateFromJSON (second, levels) && sf::fromJSON (second, fresh));
+	tassert (sf::toJSON (levels) == sf::toJSON (fresh));
+	return true;
+}
+
+bool boolVectors () {
+	std::vector<bool> flags;
+	tassert (sf::fromJSON ("[true, false, true]", flags) && flags.size() == 3 && flags[0] && !flags[1] && flags[2]);
+	tassert (sf::updateFromJSON ("[false, true]", flags) && flags.size() == 2 && !flags[0] && flags[1]);
+	tassert (!sf::fromJSON ("[true false]", flags) && flags.size() == 2, "vector must stay untouched");
+	tassert (!sf::fromJSON ("[true, 5]", flags) && flags.size() == 1 && flags[0]);
+	std::vector<std::vector<bool> > nested;
+	tassert (sf::fromJSON ("[[true], [], [false, true]]", nested) && nested.size() == 3 && nested[2][1]);
+	return true;
+}
+
 int main (int argc, char * argv[]){
 	Externizable e;
 	SubType st;
@@ -126,6 +386,13 @@ int main (int argc, char * argv[]){
 	tassert (ret, "Shall deserialize");
 
 	RUN (plainSerialization());
+	RUN (fileDeserialization());
+	RUN (maskedDeserialization());
+	RUN (stringViews());
+	RUN (internedStrings());
+	RUN (malformedContainers());
+	RUN (updateInPlace());
+	RUN (boolVectors());
 
 	return 0;
 }